@@ -2,11 +2,68 @@
 #include <vector>
 #include <map>
 #include <cmath>
-#include <random>
-#include <memory>
 #include <algorithm>
 #include <thread>
 #include <limits>
+#include <queue>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <array>
+#include <numbers>
+#include <bit>
+#include <optional>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <string_view>
+#include <cstdio>
+#include <cctype>
+#include <tuple>
+#include <new>
+#include <type_traits>
+#include <charconv>
+#include <numeric>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SIM_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define SIM_HAS_MMAP 0
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SIGNAL_KERNEL_X86 1
+#include <immintrin.h>
+#else
+#define SIGNAL_KERNEL_X86 0
+#endif
+
+// Highest log level compiled in (0 off, 1 summary, 2 per-UE events), for all
+// subsystems or per subsystem; -DSIM_LOG_LEVEL=1 builds a binary that can
+// only report the per-step KPIs.
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL 2
+#endif
+#ifndef SIM_LOG_LEVEL_ATTACH
+#define SIM_LOG_LEVEL_ATTACH SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_HANDOVER
+#define SIM_LOG_LEVEL_HANDOVER SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_SCHEDULER
+#define SIM_LOG_LEVEL_SCHEDULER SIM_LOG_LEVEL
+#endif
+#ifndef SIM_LOG_LEVEL_STATUS
+#define SIM_LOG_LEVEL_STATUS SIM_LOG_LEVEL
+#endif
 
 constexpr double FREQUENCY_5G_LOW = 600e6;    // 600 MHz (Sub-6 GHz)
 constexpr double FREQUENCY_5G_HIGH = 28e9;    // 28 GHz (mmWave)
@@ -15,117 +72,370 @@ constexpr double BOLTZMANN_CONST = 1.380649e-23; // Boltzmann constant
 constexpr double TEMPERATURE = 290;           // Temperature in Kelvin
 constexpr double NOISE_FIGURE = 5;            // Receiver noise figure in dB
 constexpr int MAX_CONNECTION_ATTEMPTS = 5;    // Max connection attempts
+constexpr double STEP_DURATION = 1.0;         // Simulated seconds per mobility step
+constexpr double BACKOFF_INTERVAL = 0.1;      // Retry backoff unit in simulated seconds
+constexpr int64_t TICKS_PER_SECOND = 1000000; // Resolution of the simulated clock (1 us)
+constexpr double UE_ANTENNA_HEIGHT = 1.5;     // UE antenna height in meters
+constexpr double SHADOWING_STD_DEV = 8.0;     // Log-normal shadowing standard deviation in dB
+constexpr double SHADOWING_DECORRELATION_DISTANCE = 50.0; // m (38.901 UMa NLOS); shadowing correlation e^(-d / this)
+constexpr double MEASUREMENT_REFRESH_DISTANCE = 10.0;     // Default displacement in meters before a UE re-measures
+constexpr double COVERAGE_MARGIN = 1.645 * SHADOWING_STD_DEV; // dB under the weakest slice RSRP floor a station still counts (95th percentile of shadowing)
+constexpr double UMA_MAX_DISTANCE = 5000.0;   // Validity limit of the UMa path loss model in meters
+constexpr double SESSION_RELEASE_PROBABILITY = 0.1; // Chance per step that a connected UE drops
+constexpr double RADIO_LINK_FAILURE_SINR = -8.0;  // dB; serving SINR below this (Qout) starts T310
+constexpr double RADIO_LINK_FAILURE_TIMER = 1.0;  // T310 in simulated seconds; the link drops once it expires
+constexpr double HANDOVER_RETRY_BACKOFF = 2.0;    // Simulated seconds after a failed handover before A3 may trigger again
+constexpr uint64_t DEFAULT_SEED = 1;          // Seed used when none is given on the command line
+constexpr int DEFAULT_PRB_COUNT = 273;        // 100 MHz carrier at 30 kHz subcarrier spacing
 
-class UserEquipment;
-class NetworkSlice;
-
-class BaseStation {
+// Verbosity per subsystem. Output above a subsystem's compiled-in level is
+// discarded at compile time by SIM_LOG; output within it costs one
+// predictable branch on the runtime level. Runtime levels are set before the
+// simulation starts and only read afterwards.
+class Log {
 public:
-    struct SignalMetrics {
-        double sinr;
-        double rsrp;
-        double rssi;
+    enum class Subsystem : uint8_t {
+        Attach, Handover, Scheduler, Status
     };
 
-    BaseStation(int id, double x, double y, double frequency, double power, double height = 25.0)
-            : id(id), x(x), y(y), frequency(frequency), transmitPower(power), height(height),
-              antennaGain(10.0) {}
+    enum class Level : uint8_t {
+        Off, Summary, Event
+    };
+
+    static constexpr size_t SUBSYSTEM_COUNT = 4;
+
+    static constexpr bool compiledIn(Subsystem subsystem, Level level) {
+        return static_cast<int>(level) <= COMPILED_LEVELS[static_cast<size_t>(subsystem)];
+    }
+
+    static bool enabled(Subsystem subsystem, Level level) {
+        return level <= levels[static_cast<size_t>(subsystem)];
+    }
+
+    static void setLevel(Subsystem subsystem, Level level) {
+        levels[static_cast<size_t>(subsystem)] = level;
+    }
+
+    // Either one level for every subsystem ("summary") or comma-separated
+    // overrides ("attach=off,status=summary"); false on an unknown name.
+    static bool configure(std::string_view spec) {
+        while (!spec.empty()) {
+            size_t comma = std::min(spec.find(','), spec.size());
+            std::string_view item = spec.substr(0, comma);
+            spec.remove_prefix(std::min(comma + 1, spec.size()));
+
+            size_t equals = item.find('=');
+            std::optional<Level> level = parseLevel(equals == std::string_view::npos ? item : item.substr(equals + 1));
+            if (!level) return false;
+            if (equals == std::string_view::npos) {
+                levels.fill(*level);
+                continue;
+            }
+            auto name = std::find(SUBSYSTEM_NAMES.begin(), SUBSYSTEM_NAMES.end(), item.substr(0, equals));
+            if (name == SUBSYSTEM_NAMES.end()) return false;
+            levels[name - SUBSYSTEM_NAMES.begin()] = *level;
+        }
+        return true;
+    }
+
+private:
+    static std::optional<Level> parseLevel(std::string_view name) {
+        if (name == "off") return Level::Off;
+        if (name == "summary") return Level::Summary;
+        if (name == "event") return Level::Event;
+        return std::nullopt;
+    }
+
+    static constexpr std::array<std::string_view, SUBSYSTEM_COUNT> SUBSYSTEM_NAMES = {
+            "attach", "handover", "scheduler", "status"
+    };
+    static constexpr std::array<int, SUBSYSTEM_COUNT> COMPILED_LEVELS = {
+            SIM_LOG_LEVEL_ATTACH, SIM_LOG_LEVEL_HANDOVER, SIM_LOG_LEVEL_SCHEDULER, SIM_LOG_LEVEL_STATUS
+    };
+    static inline std::array<Level, SUBSYSTEM_COUNT> levels = {
+            Level::Event, Level::Event, Level::Event, Level::Event
+    };
+};
+
+// Runs the statement that follows only when the subsystem logs at level:
+//     SIM_LOG(Attach, Event) log(record);
+// The runtime check is a run-once for loop rather than an if, so an else
+// after the statement binds to the caller's if, not to the macro's. break
+// and continue in the statement apply to that loop.
+#define SIM_LOG(subsystem, level)                                                                  \
+    if constexpr (!Log::compiledIn(Log::Subsystem::subsystem, Log::Level::level)) {              \
+    } else                                                                                       \
+        for (bool simLogOnce = Log::enabled(Log::Subsystem::subsystem, Log::Level::level); simLogOnce; \
+             simLogOnce = false)
 
-    SignalMetrics calculateSignalMetrics(double ueX, double ueY, double ueHeight = 1.5) const {
-        SignalMetrics metrics;
-        double distance = std::sqrt(std::pow(x - ueX, 2) + std::pow(y - ueY, 2));
+// Counter-based generator (Philox4x32-10). Every draw is a pure function of
+// (seed, stream, counter), so any thread can compute any value on demand with
+// no shared generator state, and results do not depend on evaluation order.
+class CounterRng {
+public:
+    enum class Stream : uint32_t {
+        Population, Mobility, Shadowing, SessionRelease, Fading
+    };
 
-        if (distance == 0) {
-            metrics.rsrp = transmitPower;
-            metrics.sinr = transmitPower - calculateNoisePower();
-            return metrics;
+    explicit CounterRng(uint64_t seed = DEFAULT_SEED)
+            : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)} {}
+
+    // Four independent 32-bit words for the counter (stream, a, b, c).
+    std::array<uint32_t, 4> block(Stream stream, uint32_t a, uint32_t b, uint32_t c) const {
+        std::array<uint32_t, 4> ctr{static_cast<uint32_t>(stream), a, b, c};
+        std::array<uint32_t, 2> k = key;
+        for (int round = 0; round < 10; ++round) {
+            uint64_t p0 = uint64_t{0xD2511F53} * ctr[0];
+            uint64_t p1 = uint64_t{0xCD9E8D57} * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k[0], static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k[1], static_cast<uint32_t>(p0)};
+            k[0] += 0x9E3779B9;
+            k[1] += 0xBB67AE85;
         }
+        return ctr;
+    }
 
-        double pathLoss = calculateUrbanMacroPathLoss(distance, ueHeight);
+    // Uniform in [0, 1) with 53 bits of precision.
+    double uniform(Stream stream, uint32_t a, uint32_t b, uint32_t c) const {
+        auto w = block(stream, a, b, c);
+        return toUnit(w[0], w[1]);
+    }
 
-        // Add log-normal shadowing (8 dB standard deviation)
-        static std::default_random_engine generator;
-        static std::normal_distribution<double> shadowing(0.0, 8.0);
-        double shadowingLoss = shadowing(generator);
+    // Uniform integer in [lo, hi].
+    int uniformInt(int lo, int hi, Stream stream, uint32_t a, uint32_t b, uint32_t c) const {
+        return lo + static_cast<int>(uniform(stream, a, b, c) * (hi - lo + 1));
+    }
 
-        metrics.rsrp = transmitPower - pathLoss + antennaGain - shadowingLoss;
-        double interference = calculateInterference(ueX, ueY);
-        double noise = calculateNoisePower();
-        metrics.sinr = metrics.rsrp - (10 * log10(pow(10, interference/10) + pow(10, noise/10)));
+    // Standard normal via Box-Muller on a single block.
+    double normal(Stream stream, uint32_t a, uint32_t b, uint32_t c) const {
+        return normalPair(stream, a, b, c)[0];
+    }
 
-        return metrics;
+    // Both independent normals Box-Muller yields from one block.
+    std::array<double, 2> normalPair(Stream stream, uint32_t a, uint32_t b, uint32_t c) const {
+        auto w = block(stream, a, b, c);
+        double u1 = 1.0 - toUnit(w[0], w[1]);  // (0, 1] so log() is finite
+        double u2 = toUnit(w[2], w[3]);
+        double radius = std::sqrt(-2.0 * std::log(u1));
+        double angle = 2.0 * std::numbers::pi * u2;
+        return {radius * std::cos(angle), radius * std::sin(angle)};
     }
 
-    double calculateUrbanMacroPathLoss(double distance, double ueHeight) const {
-        double dBP = 4 * (height - 1) * (ueHeight - 1) * frequency / SPEED_OF_LIGHT;
+private:
+    static double toUnit(uint32_t hi, uint32_t lo) {
+        return static_cast<double>(((uint64_t{hi} << 32 | lo) >> 11)) * 0x1.0p-53;
+    }
+
+    std::array<uint32_t, 2> key;
+};
 
-        if (distance < dBP) {
-            return 28.0 + 22*log10(distance) + 20*log10(frequency/1e9);
+// Compact reference into a SlotMap<T>: slot index in the low 24 bits and the
+// slot's generation in the high 8. A handle outlives the value it names
+// safely; once the value is erased, lookups with it fail instead of
+// reaching whatever reuses the slot.
+template <typename T>
+class SlotHandle {
+public:
+    constexpr SlotHandle() = default;
+
+    bool isValid() const { return value != INVALID; }
+    uint32_t raw() const { return value; }
+    friend bool operator==(SlotHandle, SlotHandle) = default;
+
+private:
+    template <typename> friend class SlotMap;
+
+    static constexpr uint32_t INVALID = 0xFFFFFFFF;
+    static constexpr uint32_t INDEX_BITS = 24;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+
+    constexpr SlotHandle(uint32_t slot, uint8_t generation)
+            : value(slot | uint32_t{generation} << INDEX_BITS) {}
+
+    uint32_t slot() const { return value & INDEX_MASK; }
+    uint8_t generation() const { return static_cast<uint8_t>(value >> INDEX_BITS); }
+
+    uint32_t value = INVALID;
+};
+
+// Generational slot map. Values are stored densely (erase swaps the last
+// value into the hole) so sweeps are linear, while handles go through a slot
+// table and stay valid across inserts and erases of other values. Slots whose
+// 8-bit generation is exhausted are retired rather than reused.
+template <typename T>
+class SlotMap {
+public:
+    using Handle = SlotHandle<T>;
+
+    template <typename... Args>
+    Handle emplace(Args&&... args) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
         } else {
-            return 28.0 + 40*log10(distance) + 20*log10(frequency/1e9) - 9*log10(pow(dBP,2) + pow(distance,2));
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{});
         }
+        slots[slot].dense = static_cast<uint32_t>(values.size());
+        values.emplace_back(std::forward<Args>(args)...);
+        denseToSlot.push_back(slot);
+        return Handle(slot, slots[slot].generation);
     }
 
-    double calculateInterference(double ueX, double ueY) const {
-        // In a real implementation, this would consider neighboring cells
-        return -90.0; // Constant value for basic simulation
+    bool erase(Handle handle) {
+        if (!contains(handle)) return false;
+        Slot& slot = slots[handle.slot()];
+        uint32_t last = static_cast<uint32_t>(values.size() - 1);
+        if (slot.dense != last) {
+            values[slot.dense] = std::move(values[last]);
+            denseToSlot[slot.dense] = denseToSlot[last];
+            slots[denseToSlot[last]].dense = slot.dense;
+        }
+        values.pop_back();
+        denseToSlot.pop_back();
+        if (slot.generation + 1 < RETIRED) {
+            slot.generation++;
+            freeSlots.push_back(handle.slot());
+        } else {
+            slot.generation = RETIRED;
+        }
+        return true;
     }
 
-    double calculateNoisePower() const {
-        double bandwidth = 10e6; // 10 MHz bandwidth
-        double noisePowerLinear = BOLTZMANN_CONST * TEMPERATURE * bandwidth;
-        double noisePowerDb = 10 * log10(noisePowerLinear / 0.001); // Convert to dBm
-        return noisePowerDb + NOISE_FIGURE;
+    bool contains(Handle handle) const {
+        return handle.isValid() && handle.slot() < slots.size() &&
+               slots[handle.slot()].generation == handle.generation();
     }
 
-    void addSlice(std::shared_ptr<NetworkSlice> slice) {
-        slices.push_back(slice);
+    T* get(Handle handle) { return contains(handle) ? &values[slots[handle.slot()].dense] : nullptr; }
+    const T* get(Handle handle) const { return contains(handle) ? &values[slots[handle.slot()].dense] : nullptr; }
+
+    // Dense access, in storage order
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    T& operator[](size_t dense) { return values[dense]; }
+    const T& operator[](size_t dense) const { return values[dense]; }
+    size_t indexOf(Handle handle) const { return slots[handle.slot()].dense; }  // handle must be live
+    Handle handleAt(size_t dense) const {
+        uint32_t slot = denseToSlot[dense];
+        return Handle(slot, slots[slot].generation);
     }
 
-    // Getters
-    int getId() const { return id; }
-    double getX() const { return x; }
-    double getY() const { return y; }
-    double getFrequency() const { return frequency; }
+    auto begin() { return values.begin(); }
+    auto end() { return values.end(); }
+    auto begin() const { return values.begin(); }
+    auto end() const { return values.end(); }
 
 private:
-    int id;
-    double x, y;
-    double frequency;
-    double transmitPower;
-    double height;
-    double antennaGain;
-    std::vector<std::shared_ptr<NetworkSlice>> slices;
+    // Never issued in a handle, so a retired slot matches no handle
+    static constexpr uint8_t RETIRED = std::numeric_limits<uint8_t>::max();
+
+    struct Slot {
+        uint32_t dense = 0;
+        uint8_t generation = 0;
+    };
+
+    std::vector<T> values;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
 };
 
+class BaseStation;
+class NetworkSlice;
+
+using StationHandle = SlotHandle<BaseStation>;
+using SliceHandle = SlotHandle<NetworkSlice>;
+
 class NetworkSlice {
 public:
-    enum class SliceType {
+    enum class SliceType : uint8_t {
         eMBB, URLLC, mMTC
     };
 
-    NetworkSlice(int id, SliceType type, double priority, double bandwidth)
-            : id(id), type(type), priority(priority), bandwidth(bandwidth) {}
+    static constexpr size_t TYPE_COUNT = 3;
+
+    // Capacity of one slice pool on one gNB
+    struct Profile {
+        double priority;
+        double bandwidth;  // MHz
+    };
+
+    // Indexed by SliceType
+    using ProfileSet = std::array<Profile, TYPE_COUNT>;
+
+    NetworkSlice(int id, SliceType type, double priority, double bandwidth,
+                 StationHandle station = StationHandle{})
+            : id(id), type(type), station(station), priorityPermille(std::llround(priority * 1000)),
+              capacityUnits(toUnits(bandwidth)), bandwidthUnits(capacityUnits) {}
+
+    NetworkSlice(const NetworkSlice&) = delete;
+    NetworkSlice& operator=(const NetworkSlice&) = delete;
 
-    double allocateResources(double requestedResources) {
+    // Moves let slices live in a SlotMap; they are only valid while no
+    // attach is in flight, as when slices are added or removed between events.
+    NetworkSlice(NetworkSlice&& other) noexcept
+            : id(other.id), type(other.type), station(other.station), priorityPermille(other.priorityPermille),
+              capacityUnits(other.capacityUnits),
+              bandwidthUnits(other.bandwidthUnits.load(std::memory_order_relaxed)) {}
+
+    NetworkSlice& operator=(NetworkSlice&& other) noexcept {
+        id = other.id;
+        type = other.type;
+        station = other.station;
+        priorityPermille = other.priorityPermille;
+        capacityUnits = other.capacityUnits;
+        bandwidthUnits.store(other.bandwidthUnits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    // Capacity is kept in fixed-point kHz so repeated reserve/release cycles are
+    // exact integer arithmetic and cannot drift the way += / -= on doubles does.
+    // Grants are handed out and taken back in these units, so a holder returns
+    // exactly what it was given.
+    static constexpr double UNITS_PER_MHZ = 1000.0;
+
+    static int64_t toUnits(double mhz) { return std::llround(mhz * UNITS_PER_MHZ); }
+    static double toMHz(int64_t units) { return units / UNITS_PER_MHZ; }
+
+    // Lock-free reserve: a CAS loop on the remaining capacity, so concurrent
+    // attaches against the same slice never block each other. Returns the
+    // units granted, 0 if none.
+    int64_t allocateResources(double requestedResources) {
         if (requestedResources < 0.1) return 0;
-        double allocated = std::min(requestedResources, bandwidth * priority);
-        bandwidth -= allocated;
-        return allocated;
+        int64_t requested = toUnits(requestedResources);
+        int64_t available = bandwidthUnits.load(std::memory_order_relaxed);
+        int64_t granted;
+        do {
+            granted = std::min(requested, grantableUnits(available));
+            if (granted <= 0) return 0;
+        } while (!bandwidthUnits.compare_exchange_weak(available, available - granted,
+                                                       std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed));
+        return granted;
     }
 
     double checkAvailableResources() const {
-        return bandwidth * priority;
+        return toMHz(grantableUnits(bandwidthUnits.load(std::memory_order_acquire)));
     }
 
-    void releaseResources(double resources) {
-        bandwidth += resources;
+    // Hands back units an earlier allocateResources granted
+    void releaseResources(int64_t units) {
+        bandwidthUnits.fetch_add(units, std::memory_order_acq_rel);
     }
 
     int getId() const { return id; }
     SliceType getType() const { return type; }
+    StationHandle getStation() const { return station; }
+    double getCapacity() const { return toMHz(capacityUnits); }
+    double getAllocatedBandwidth() const {
+        return toMHz(capacityUnits - bandwidthUnits.load(std::memory_order_acquire));
+    }
 
-    std::string getTypeName() const {
+    std::string getTypeName() const { return typeName(type); }
+
+    static std::string typeName(SliceType type) {
         switch (type) {
             case SliceType::eMBB: return "eMBB";
             case SliceType::URLLC: return "URLLC";
@@ -135,278 +445,4780 @@ public:
     }
 
 private:
+    int64_t grantableUnits(int64_t available) const {
+        return available * priorityPermille / 1000;
+    }
+
     int id;
     SliceType type;
-    double priority;
-    double bandwidth;
+    StationHandle station;  // the gNB whose pool this is
+    int64_t priorityPermille;
+    int64_t capacityUnits;
+    std::atomic<int64_t> bandwidthUnits;
 };
 
-class UserEquipment {
+// Spatially correlated log-normal shadowing around one station, after
+// Gudmundson: white Gaussian noise on a square grid, smoothed by a first-order
+// recursive filter along the rows and then the columns. That keeps unit
+// variance with correlation e^(-(|dx| + |dy|) / decorrelation distance).
+// The filter wraps around, so the tile is periodic and a fixed 64 KiB covers
+// any distance from the station; lookups interpolate bilinearly.
+class ShadowingMap {
 public:
-    struct SliceRequirements {
-        double minSinr;
-        double minRsrp;
-        double bandwidthPriority;
-    };
+    static constexpr uint32_t SIZE = 128;  // grid points per side, a power of two
+    static constexpr float SPACING = static_cast<float>(SHADOWING_DECORRELATION_DISTANCE / 4);  // tile period 1.6 km
 
-    UserEquipment(int id, double x, double y, double speed,
-                  NetworkSlice::SliceType requiredSlice, double requiredBandwidth)
-            : id(id), x(x), y(y), speed(speed),
-              requiredSlice(requiredSlice), requiredBandwidth(requiredBandwidth),
-              connected(false), servingStation(nullptr), allocatedSlice(nullptr),
-              connectionAttempts(0) {}
+    // Noise is keyed by (station, row, column), so a station's map depends
+    // only on the seed and its id.
+    void generate(const CounterRng& rng, uint32_t stationId) {
+        field.resize(SIZE * SIZE);
+        for (uint32_t row = 0; row < SIZE; ++row) {
+            for (uint32_t column = 0; column < SIZE; column += 2) {
+                auto noise = rng.normalPair(CounterRng::Stream::Shadowing, stationId, row, column);
+                field[row * SIZE + column] = static_cast<float>(noise[0]);
+                field[row * SIZE + column + 1] = static_cast<float>(noise[1]);
+            }
+        }
+        for (uint32_t row = 0; row < SIZE; ++row) {
+            smooth(&field[row * SIZE], 1);
+        }
+        for (uint32_t column = 0; column < SIZE; ++column) {
+            smooth(&field[column], SIZE);
+        }
+        // Bilinear lookups between grid points average neighbours with
+        // correlation a, which on average scales the variance by
+        // (2/3 + a/3)^2; the field is scaled up by as much in return.
+        const double a = std::exp(-SPACING / SHADOWING_DECORRELATION_DISTANCE);
+        const auto scale = static_cast<float>(SHADOWING_STD_DEV / (2.0 / 3 + a / 3));
+        for (float& value : field) {
+            value *= scale;
+        }
+    }
 
-    void move(double timeStep) {
-        x += speed * timeStep * (rand() % 3 - 1);
-        y += speed * timeStep * (rand() % 3 - 1);
+    // Shadowing loss in dB at offset (dx, dy) meters from the station; 0 for
+    // a map that was never generated (field == nullptr).
+    static float sample(const float* field, float dx, float dy) {
+        if (!field) return 0;
+        float u = dx * (1 / SPACING), v = dy * (1 / SPACING);
+        float column = std::floor(u), row = std::floor(v);
+        float fu = u - column, fv = v - row;
+        uint32_t c0 = static_cast<uint32_t>(static_cast<int32_t>(column)) & (SIZE - 1);
+        uint32_t r0 = static_cast<uint32_t>(static_cast<int32_t>(row)) & (SIZE - 1);
+        uint32_t c1 = (c0 + 1) & (SIZE - 1), r1 = (r0 + 1) & (SIZE - 1);
+        float top = field[r0 * SIZE + c0] + fu * (field[r0 * SIZE + c1] - field[r0 * SIZE + c0]);
+        float bottom = field[r1 * SIZE + c0] + fu * (field[r1 * SIZE + c1] - field[r1 * SIZE + c0]);
+        return top + fv * (bottom - top);
     }
 
-    void connect(std::vector<BaseStation>& stations,
-                 std::vector<std::shared_ptr<NetworkSlice>>& slices) {
-        connectionAttempts++;
-        ConnectionCandidate bestCandidate = evaluatePotentialConnections(stations, slices);
+    float sample(double dx, double dy) const {
+        return sample(data(), static_cast<float>(dx), static_cast<float>(dy));
+    }
 
-        if (bestCandidate.isViable()) {
-            establishConnection(bestCandidate);
-        } else {
-            handleConnectionFailure(bestCandidate);
-        }
+    const float* data() const { return field.empty() ? nullptr : field.data(); }
 
-        if (!connected && connectionAttempts < MAX_CONNECTION_ATTEMPTS) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100 * connectionAttempts));
+private:
+    // Circular AR(1), x[n] = a x[n - 1] + sqrt(1 - a^2) w[n], around a ring of
+    // SIZE points. A pass from zero yields the state the ring wraps into,
+    // which seeds the real pass so the tile has no seam.
+    static void smooth(float* line, size_t stride) {
+        const double a = std::exp(-SPACING / SHADOWING_DECORRELATION_DISTANCE);
+        const double b = std::sqrt(1 - a * a);
+        double state = 0;
+        for (uint32_t n = 0; n < SIZE; ++n) {
+            state = a * state + b * line[n * stride];
         }
+        state /= 1 - std::pow(a, SIZE);
+        for (uint32_t n = 0; n < SIZE; ++n) {
+            state = a * state + b * line[n * stride];
+            line[n * stride] = static_cast<float>(state);
+        }
+    }
+
+    std::vector<float> field;  // dB, row-major, row = y
+};
+
+class BaseStation {
+public:
+    struct SignalMetrics {
+        double sinr;
+        double rsrp;
+    };
+
+    BaseStation(int id, double x, double y, double frequency, double power, double height = 25.0)
+            : id(id), x(x), y(y), frequency(frequency), transmitPower(power), height(height),
+              antennaGain(10.0) {
+        refreshPropagationConstants();
+    }
+
+    double calculateBreakpointDistance(double ueHeight) const {
+        if (ueHeight == UE_ANTENNA_HEIGHT) return breakpointDistance;
+        return 4 * (height - 1) * (ueHeight - 1) * frequency / SPEED_OF_LIGHT;
     }
 
-    void disconnect() {
-        if (connected && allocatedSlice) {
-            allocatedSlice->releaseResources(allocatedBandwidth);
-            connected = false;
-            servingStation = nullptr;
-            allocatedSlice = nullptr;
-            std::cout << "UE " << id << " disconnected\n";
+    double calculateUrbanMacroPathLoss(double distance, double ueHeight) const {
+        return calculateUrbanMacroPathLossSquared(distance * distance, ueHeight);
+    }
+
+    double calculateNoisePower() const { return noisePower; }
+
+    // Distance beyond which the median RSRP stays below threshold (dBm), so
+    // the station is neither an attach candidate nor a relevant interferer.
+    // Capped at the validity limit of the path loss model.
+    double calculateCoverageRadius(double threshold) const {
+        double maxPathLoss = transmitPower + antennaGain - threshold;
+        if (calculateUrbanMacroPathLoss(UMA_MAX_DISTANCE, UE_ANTENNA_HEIGHT) <= maxPathLoss) {
+            return UMA_MAX_DISTANCE;
         }
+        double lo = 1.0, hi = UMA_MAX_DISTANCE;
+        for (int iteration = 0; iteration < 40; ++iteration) {
+            double mid = 0.5 * (lo + hi);
+            (calculateUrbanMacroPathLoss(mid, UE_ANTENNA_HEIGHT) <= maxPathLoss ? lo : hi) = mid;
+        }
+        return hi;
+    }
+
+    // Each gNB owns one pool per slice type
+    void setSlice(NetworkSlice::SliceType type, SliceHandle slice) {
+        slices[static_cast<size_t>(type)] = slice;
+    }
+
+    SliceHandle getSlice(NetworkSlice::SliceType type) const {
+        return slices[static_cast<size_t>(type)];
     }
 
+    enum class Band : uint8_t {
+        FR1, FR2
+    };
+
+    // FR2 (mmWave) starts at 24.25 GHz
+    Band getBand() const { return bandFor(frequency); }
+
+    static Band bandFor(double frequency) { return frequency >= 24.25e9 ? Band::FR2 : Band::FR1; }
+
+    void setPrbCount(int value) { prbCount = value; }
+
+    void generateShadowingMap(const CounterRng& rng) { shadowingMap.generate(rng, static_cast<uint32_t>(id)); }
+
     // Getters
     int getId() const { return id; }
-    bool isConnected() const { return connected; }
     double getX() const { return x; }
     double getY() const { return y; }
-    NetworkSlice::SliceType getRequiredSlice() const { return requiredSlice; }
+    double getFrequency() const { return frequency; }
+    double getTransmitPower() const { return transmitPower; }
+    double getAntennaGain() const { return antennaGain; }
+    double getHeight() const { return height; }
+    double getPathLossIntercept() const { return pathLossIntercept; }
+    double getNoisePowerMw() const { return noisePowerMw; }
+    int getPrbCount() const { return prbCount; }
+    const ShadowingMap& getShadowingMap() const { return shadowingMap; }
 
 private:
-    struct ConnectionCandidate {
-        BaseStation* station = nullptr;
-        std::shared_ptr<NetworkSlice> slice = nullptr;
-        double sinr = -std::numeric_limits<double>::infinity();
-        double rsrp = -std::numeric_limits<double>::infinity();
-        double availableBandwidth = 0;
+    // Works on d^2 so callers need no sqrt: 22 log10(d) = 11 log10(d^2), and
+    // 40 log10(d) = 20 log10(d^2).
+    double calculateUrbanMacroPathLossSquared(double distanceSquared, double ueHeight) const {
+        double dBP = calculateBreakpointDistance(ueHeight);
 
-        bool isViable() const {
-            return station != nullptr && slice != nullptr;
+        if (distanceSquared < dBP * dBP) {
+            return pathLossIntercept + 11 * log10(distanceSquared);
+        } else {
+            return pathLossIntercept + 20 * log10(distanceSquared) - 9 * log10(dBP * dBP + distanceSquared);
         }
-    };
+    }
 
-    const std::map<NetworkSlice::SliceType, SliceRequirements> sliceRequirements = {
-            {NetworkSlice::SliceType::eMBB, {5.0, -110.0, 0.7}},
-            {NetworkSlice::SliceType::URLLC, {10.0, -105.0, 0.9}},
-            {NetworkSlice::SliceType::mMTC, {0.0, -120.0, 0.3}}
-    };
+    // Everything here depends only on the station's configuration, so it is
+    // computed once instead of on every signal evaluation. The radio
+    // configuration is fixed for the station's life, since the StationBlock,
+    // coverage radius and grid are built from it; a retuned site is removed
+    // and added again through FiveGNetwork.
+    void refreshPropagationConstants() {
+        breakpointDistance = 4 * (height - 1) * (UE_ANTENNA_HEIGHT - 1) * frequency / SPEED_OF_LIGHT;
+        pathLossIntercept = 28.0 + 20 * log10(frequency / 1e9);
+
+        double bandwidth = 10e6; // 10 MHz bandwidth
+        double noisePowerLinear = BOLTZMANN_CONST * TEMPERATURE * bandwidth;
+        noisePower = 10 * log10(noisePowerLinear / 0.001) + NOISE_FIGURE; // Convert to dBm
+        noisePowerMw = pow(10, noisePower / 10);
+    }
+
+    int id;
+    double x, y;
+    double frequency;
+    double transmitPower;
+    double height;
+    double antennaGain;
+    int prbCount = DEFAULT_PRB_COUNT;
+    std::array<SliceHandle, NetworkSlice::TYPE_COUNT> slices{};
+    ShadowingMap shadowingMap;
 
-    ConnectionCandidate evaluatePotentialConnections(
-            std::vector<BaseStation>& stations,
-            std::vector<std::shared_ptr<NetworkSlice>>& slices) {
+    // Derived from the configuration above by refreshPropagationConstants()
+    double breakpointDistance = 0;
+    double pathLossIntercept = 0;
+    double noisePower = 0;
+    double noisePowerMw = 0;
+};
 
-        ConnectionCandidate best;
-        std::vector<ConnectionCandidate> viableCandidates;
+// Per-station propagation inputs laid out as structure-of-arrays, the input
+// format of SignalKernel, copied from each station's cached constants.
+// Rebuilt whenever the set of stations changes.
+// Block position s holds the station with handle[s].
+struct StationBlock {
+    std::vector<int32_t> id;
+    std::vector<StationHandle> handle;
+    std::vector<SliceHandle> slice;           // slice[s * NetworkSlice::TYPE_COUNT + type]
+    std::vector<float> x, y;
+    std::vector<float> eirp;                  // transmit power + antenna gain, dBm
+    std::vector<float> pathLossIntercept;     // 28 + 20 log10(f / 1 GHz)
+    std::vector<float> breakpointSquared;     // dBP^2, m^2
+    std::vector<double> noiseMw;              // receiver noise floor, linear mW
+    std::vector<uint16_t> channel;            // stations on the same carrier share a channel
+    std::vector<const float*> shadowing;      // each station's ShadowingMap field
+    size_t channelCount = 0;
+    std::vector<uint32_t> positionOfDense;    // block position of the station at each SlotMap dense index
 
-        for (auto& station : stations) {
-            BaseStation::SignalMetrics metrics = station.calculateSignalMetrics(x, y);
+    // Neighbour relation table: block positions whose coverage overlaps
+    // station s are neighbours[neighbourStart[s], neighbourStart[s + 1]).
+    std::vector<uint32_t> neighbourStart;
+    std::vector<uint32_t> neighbours;
 
-            if (metrics.sinr < sliceRequirements.at(requiredSlice).minSinr ||
-                metrics.rsrp < sliceRequirements.at(requiredSlice).minRsrp) {
-                continue;
+    // order lists the stations' dense positions in the order they should
+    // appear in the block.
+    void assign(const SlotMap<BaseStation>& stations, const std::vector<uint32_t>& order) {
+        size_t n = order.size();
+        id.resize(n);
+        handle.resize(n);
+        slice.resize(n * NetworkSlice::TYPE_COUNT);
+        for (auto* column : {&x, &y, &eirp, &pathLossIntercept, &breakpointSquared}) {
+            column->resize(n);
+        }
+        noiseMw.resize(n);
+        channel.resize(n);
+        shadowing.resize(n);
+        positionOfDense.resize(n);
+        std::vector<double> carriers;
+        for (size_t s = 0; s < n; ++s) {
+            const BaseStation& station = stations[order[s]];
+            positionOfDense[order[s]] = static_cast<uint32_t>(s);
+            double dBP = station.calculateBreakpointDistance(UE_ANTENNA_HEIGHT);
+            id[s] = station.getId();
+            handle[s] = stations.handleAt(order[s]);
+            for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+                slice[s * NetworkSlice::TYPE_COUNT + type] = station.getSlice(static_cast<NetworkSlice::SliceType>(type));
             }
+            x[s] = static_cast<float>(station.getX());
+            y[s] = static_cast<float>(station.getY());
+            eirp[s] = static_cast<float>(station.getTransmitPower() + station.getAntennaGain());
+            pathLossIntercept[s] = static_cast<float>(station.getPathLossIntercept());
+            breakpointSquared[s] = static_cast<float>(dBP * dBP);
+            noiseMw[s] = station.getNoisePowerMw();
+            shadowing[s] = station.getShadowingMap().data();
 
-            for (auto& slice : slices) {
-                if (slice->getType() == requiredSlice) {
-                    double availableBW = slice->checkAvailableResources();
-                    if (availableBW >= requiredBandwidth * 0.5) {
-                        viableCandidates.emplace_back(
-                                ConnectionCandidate{&station, slice,
-                                                    metrics.sinr, metrics.rsrp, availableBW});
-                    }
-                }
+            auto carrier = std::find(carriers.begin(), carriers.end(), station.getFrequency());
+            channel[s] = static_cast<uint16_t>(carrier - carriers.begin());
+            if (carrier == carriers.end()) {
+                carriers.push_back(station.getFrequency());
             }
         }
+        channelCount = carriers.size();
+    }
+
+    size_t size() const { return x.size(); }
 
-        if (!viableCandidates.empty()) {
-            std::sort(viableCandidates.begin(), viableCandidates.end(),
-                      [](const ConnectionCandidate& a, const ConnectionCandidate& b) {
-                          return (0.7 * a.sinr + 0.2 * a.rsrp + 0.1 * a.availableBandwidth) >
-                                 (0.7 * b.sinr + 0.2 * b.rsrp + 0.1 * b.availableBandwidth);
-                      });
+    // Shadowing loss in dB seen from station s at (ueX, ueY)
+    float shadowingDb(uint32_t s, float ueX, float ueY) const {
+        return ShadowingMap::sample(shadowing[s], ueX - x[s], ueY - y[s]);
+    }
+
+    // Turns one UE's RSRP row (dBm, shadowing included) over the block
+    // positions members[0..count) into full metrics. Interference at station
+    // s is the received power of every other member on s's channel; it is
+    // taken as the channel total minus s's own share, so one pass sums the
+    // totals and one pass derives SINR: O(count) per UE.
+    void deriveSignalMetrics(const uint32_t* members, size_t count, const float* rsrp,
+                             BaseStation::SignalMetrics* metrics) const {
+        constexpr double DB_TO_LOG2 = std::numbers::ln10 / std::numbers::ln2 / 10;  // 10^(x/10) = 2^(x * this)
+        thread_local std::vector<double> receivedMw, channelTotalMw;
+        receivedMw.resize(count);
+        channelTotalMw.assign(channelCount, 0.0);
 
-            best = viableCandidates.front();
+        for (size_t j = 0; j < count; ++j) {
+            receivedMw[j] = std::exp2(rsrp[j] * DB_TO_LOG2);
+            channelTotalMw[channel[members[j]]] += receivedMw[j];
         }
 
-        return best;
+        for (size_t j = 0; j < count; ++j) {
+            uint32_t s = members[j];
+            double interferenceMw = std::max(channelTotalMw[channel[s]] - receivedMw[j], 0.0);
+            metrics[j].rsrp = rsrp[j];
+            metrics[j].sinr = 10 * log10(receivedMw[j] / (interferenceMw + noiseMw[s]));
+        }
     }
+};
 
-    void establishConnection(const ConnectionCandidate& candidate) {
-        double allocated = candidate.slice->allocateResources(requiredBandwidth);
-        if (allocated > 0) {
-            connected = true;
-            servingStation = candidate.station;
-            allocatedSlice = candidate.slice;
-            currentSignal = candidate.sinr;
-            allocatedBandwidth = allocated;
-            connectionAttempts = 0;
-
-            std::cout << "UE " << id << " connected to gNB " << servingStation->getId()
-                      << " on " << allocatedSlice->getTypeName() << " slice\n"
-                      << "  - Allocated BW: " << allocated << "/" << requiredBandwidth << " MHz\n"
-                      << "  - SINR: " << currentSignal << " dB, RSRP: " << candidate.rsrp << " dBm\n";
-        } else {
-            std::cout << "UE " << id << " failed to allocate resources on "
-                      << candidate.slice->getTypeName() << " slice\n";
+// Uniform grid over station positions with cells as wide as the median
+// coverage radius. Stations that reach further (macro sites among small
+// cells) go on a wide-area layer whose cells are a whole number of grid
+// cells across, wide enough for the largest radius, so every station a UE
+// can hear lies in the 3x3 cells around it on one layer or the other.
+// Stations are kept in the block in row-major cell order, grid layer first,
+// which makes each row of three adjacent cells one contiguous block range:
+// the neighbourhood of a UE is at most six ranges, and its size depends on
+// local station density rather than on the size of the network or its
+// largest site.
+class StationGrid {
+public:
+    // Neighbour relations kept per station, deepest coverage overlap first
+    static constexpr size_t MAX_NEIGHBOURS = 16;
+
+    struct Range {
+        uint32_t begin, end;
+    };
+
+    using Neighbourhood = std::array<Range, 6>;
+
+    // threshold is the median RSRP (dBm) below which a station no longer
+    // counts, see BaseStation::calculateCoverageRadius.
+    void build(const SlotMap<BaseStation>& stations, double threshold) {
+        double minX = std::numeric_limits<double>::infinity(), minY = minX;
+        double maxX = -minX, maxY = -minX;
+        std::vector<double> radius(stations.size());
+        for (size_t s = 0; s < stations.size(); ++s) {
+            minX = std::min(minX, stations[s].getX());
+            minY = std::min(minY, stations[s].getY());
+            maxX = std::max(maxX, stations[s].getX());
+            maxY = std::max(maxY, stations[s].getY());
+            radius[s] = stations[s].calculateCoverageRadius(threshold);
+        }
+        if (stations.empty()) {
+            minX = minY = maxX = maxY = 0;
         }
+        cellSize = 1.0;
+        double maxRadius = 1.0;
+        if (!radius.empty()) {
+            std::vector<double> sorted = radius;
+            auto median = sorted.begin() + sorted.size() / 2;
+            std::nth_element(sorted.begin(), median, sorted.end());
+            cellSize = std::max(cellSize, *median);
+            maxRadius = std::max(maxRadius, *std::max_element(sorted.begin(), sorted.end()));
+        }
+        originX = minX;
+        originY = minY;
+        columns = static_cast<int32_t>((maxX - minX) / cellSize) + 1;
+        rows = static_cast<int32_t>((maxY - minY) / cellSize) + 1;
+        wideFactor = static_cast<int32_t>(std::ceil(maxRadius / cellSize));
+        wideColumns = (columns + wideFactor - 1) / wideFactor;
+        wideRows = (rows + wideFactor - 1) / wideFactor;
+        const size_t gridCells = static_cast<size_t>(columns) * rows;
+
+        // Counting sort of stations by cell, wide-area cells after the grid's
+        std::vector<uint32_t> cellOf(stations.size());
+        cellStart.assign(gridCells + static_cast<size_t>(wideColumns) * wideRows + 1, 0);
+        for (size_t s = 0; s < stations.size(); ++s) {
+            cellOf[s] = cellIndex(stations[s].getX(), stations[s].getY());
+            if (radius[s] > cellSize) {
+                cellOf[s] = static_cast<uint32_t>(gridCells + wideCellOf(cellOf[s]));
+            }
+            cellStart[cellOf[s] + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); ++c) {
+            cellStart[c] += cellStart[c - 1];
+        }
+        std::vector<uint32_t> order(stations.size());
+        std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+        for (size_t s = 0; s < stations.size(); ++s) {
+            order[fill[cellOf[s]]++] = static_cast<uint32_t>(s);
+        }
+        block.assign(stations, order);
+        buildNeighbourRelations(radius, order);
     }
 
-    void handleConnectionFailure(const ConnectionCandidate& bestCandidate) {
-        if (bestCandidate.station) {
-            std::cout << "UE " << id << " could not connect (Best Candidate: "
-                      << "SINR " << bestCandidate.sinr << " dB, "
-                      << "RSRP " << bestCandidate.rsrp << " dBm, "
-                      << "BW " << bestCandidate.availableBandwidth << " MHz)\n";
-        } else {
-            std::cout << "UE " << id << " found no viable stations (Attempt "
-                      << connectionAttempts << ")\n";
+    // Row-major cell of a position; positions outside the grid clamp to the
+    // nearest edge cell, whose neighbourhood covers everything they can hear.
+    uint32_t cellIndex(double x, double y) const {
+        auto cx = std::clamp(static_cast<int32_t>(std::floor((x - originX) / cellSize)), 0, columns - 1);
+        auto cy = std::clamp(static_cast<int32_t>(std::floor((y - originY) / cellSize)), 0, rows - 1);
+        return static_cast<uint32_t>(cy * columns + cx);
+    }
+
+    // Block ranges holding every station in the 3x3 cells around cell on
+    // both layers; returns how many ranges were written (empty rows are
+    // skipped).
+    size_t neighbourhood(uint32_t cell, Neighbourhood& out) const {
+        size_t count = 0;
+        auto addRows = [&](uint32_t base, int32_t cx, int32_t cy, int32_t width, int32_t height) {
+            int32_t firstColumn = std::max(cx - 1, 0);
+            int32_t lastColumn = std::min(cx + 1, width - 1);
+            for (int32_t row = std::max(cy - 1, 0); row <= std::min(cy + 1, height - 1); ++row) {
+                Range range{cellStart[base + row * width + firstColumn],
+                            cellStart[base + row * width + lastColumn + 1]};
+                if (range.begin < range.end) {
+                    out[count++] = range;
+                }
+            }
+        };
+        addRows(0, static_cast<int32_t>(cell) % columns, static_cast<int32_t>(cell) / columns, columns, rows);
+        uint32_t wideCell = wideCellOf(cell);
+        addRows(static_cast<uint32_t>(columns) * rows, static_cast<int32_t>(wideCell) % wideColumns,
+                static_cast<int32_t>(wideCell) / wideColumns, wideColumns, wideRows);
+        return count;
+    }
+
+    const StationBlock& stations() const { return block; }
+
+private:
+    // Wide-area cell containing grid cell
+    uint32_t wideCellOf(uint32_t cell) const {
+        int32_t cx = static_cast<int32_t>(cell) % columns / wideFactor;
+        int32_t cy = static_cast<int32_t>(cell) / columns / wideFactor;
+        return static_cast<uint32_t>(cy * wideColumns + cx);
+    }
+
+    // Two stations are neighbours when their coverage discs overlap. Only
+    // the station's own neighbourhood is scanned, and of those the
+    // MAX_NEIGHBOURS with the deepest overlap are kept, in block order.
+    void buildNeighbourRelations(const std::vector<double>& denseRadius, const std::vector<uint32_t>& order) {
+        std::vector<double> radius(order.size());
+        for (size_t s = 0; s < order.size(); ++s) {
+            radius[s] = denseRadius[order[s]];
+        }
+        std::vector<std::pair<double, uint32_t>> candidates;  // (overlap, block position)
+        block.neighbourStart.assign(1, 0);
+        block.neighbours.clear();
+        for (size_t s = 0; s < order.size(); ++s) {
+            Neighbourhood ranges;
+            size_t rangeCount = neighbourhood(cellIndex(block.x[s], block.y[s]), ranges);
+            candidates.clear();
+            for (size_t r = 0; r < rangeCount; ++r) {
+                for (uint32_t n = ranges[r].begin; n < ranges[r].end; ++n) {
+                    double overlap = radius[s] + radius[n] - std::hypot(block.x[n] - block.x[s],
+                                                                        block.y[n] - block.y[s]);
+                    if (n != s && overlap > 0) {
+                        candidates.emplace_back(overlap, n);
+                    }
+                }
+            }
+            if (candidates.size() > MAX_NEIGHBOURS) {
+                std::partial_sort(candidates.begin(), candidates.begin() + MAX_NEIGHBOURS, candidates.end(),
+                                  [](const auto& a, const auto& b) {
+                                      return a.first > b.first || (a.first == b.first && a.second < b.second);
+                                  });
+                candidates.resize(MAX_NEIGHBOURS);
+                std::sort(candidates.begin(), candidates.end(),
+                          [](const auto& a, const auto& b) { return a.second < b.second; });
+            }
+            for (const auto& candidate : candidates) {
+                block.neighbours.push_back(candidate.second);
+            }
+            block.neighbourStart.push_back(static_cast<uint32_t>(block.neighbours.size()));
         }
     }
 
-    int id;
-    double x, y;
-    double speed;
-    NetworkSlice::SliceType requiredSlice;
-    double requiredBandwidth;
-    bool connected;
-    BaseStation* servingStation;
-    std::shared_ptr<NetworkSlice> allocatedSlice;
-    double currentSignal;
-    double allocatedBandwidth;
-    int connectionAttempts;
+    StationBlock block;
+    std::vector<uint32_t> cellStart;  // stations of cell c are block[cellStart[c], cellStart[c + 1])
+    double originX = 0, originY = 0;
+    double cellSize = 1.0;
+    int32_t columns = 1, rows = 1;
+    int32_t wideFactor = 1;           // grid cells per wide-area cell, across
+    int32_t wideColumns = 1, wideRows = 1;
 };
 
-class FiveGNetwork {
+// Median (pre-shadowing) RSRP of a block of UEs against a block of stations
+// under the UMa path loss model. The scalar, AVX2 and AVX-512 paths evaluate
+// the same float expression, including a polynomial logarithm in place of
+// libm's log10 (AVX-512 implies FMA, so that path may differ in the last
+// bit), and the widest one the CPU supports is picked at runtime.
+// log10(d) is taken as log10(d^2) / 2, so no square root is needed, and
+// distances under 1 m are clamped to 1 m.
+class SignalKernel {
 public:
-    FiveGNetwork() {
-        rng.seed(std::random_device()());
-    }
+    enum class Isa {
+        Scalar, Avx2, Avx512
+    };
 
-    void initialize() {
-        createBaseStations();
-        createNetworkSlices();
-        createUserEquipment();
+    // Writes rsrp[u * stride + (s - begin)] for every UE u and every station s
+    // in the block range [begin, end).
+    static void measure(const float* ueX, const float* ueY, size_t ueCount,
+                        const StationBlock& stations, size_t begin, size_t end,
+                        float* rsrp, size_t stride) {
+        switch (isa()) {
+#if SIGNAL_KERNEL_X86
+            case Isa::Avx512: measureAvx512(ueX, ueY, ueCount, stations, begin, end, rsrp, stride); return;
+            case Isa::Avx2: measureAvx2(ueX, ueY, ueCount, stations, begin, end, rsrp, stride); return;
+#endif
+            default: measureScalar(ueX, ueY, ueCount, stations, begin, end, rsrp, stride); return;
+        }
     }
 
-    void runSimulation(int steps) {
-        for (int i = 0; i < steps; ++i) {
-            auto start = std::chrono::steady_clock::now();
-            std::cout << "\n=== Simulation Step " << i + 1 << " ===\n";
+    // One UE against an arbitrary list of block positions, e.g. a serving
+    // cell and its neighbours. Scalar: the positions are scattered over the
+    // block, and a list holds at most StationGrid::MAX_NEIGHBOURS + 1.
+    static void measureList(float ueX, float ueY, const StationBlock& stations,
+                            const uint32_t* members, size_t count, float* rsrp) {
+        for (size_t j = 0; j < count; ++j) {
+            rsrp[j] = rsrpScalar(ueX, ueY, stations, members[j]);
+        }
+    }
 
-            for (auto &ue: ues) {
-                ue.move(1.0);
+    static Isa detectIsa() {
+#if SIGNAL_KERNEL_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return Isa::Avx512;
+        if (__builtin_cpu_supports("avx2")) return Isa::Avx2;
+#endif
+        return Isa::Scalar;
+    }
 
-                if (ue.isConnected() && (rand() % 10 == 0)) {
-                    ue.disconnect();
-                }
+    // Forces a narrower path, e.g. to compare results; requests for an
+    // instruction set the CPU lacks fall back to the detected one.
+    static void setIsa(Isa requested) {
+        selectedIsa() = std::min(requested, detectIsa());
+    }
 
-                if (!ue.isConnected()) {
-                    ue.connect(baseStations, slices);
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                }
-            }
+    static Isa isa() { return selectedIsa(); }
 
-            displayStatus();
+    static const char* isaName(Isa value) {
+        switch (value) {
+            case Isa::Avx512: return "AVX-512";
+            case Isa::Avx2: return "AVX2";
+            default: return "scalar";
         }
     }
 
 private:
-    void createBaseStations() {
-        baseStations.emplace_back(1, 0, 0, FREQUENCY_5G_LOW, 40);
-        baseStations.emplace_back(2, 1000, 1000, FREQUENCY_5G_HIGH, 30);
-        baseStations.emplace_back(3, 0, 1000, FREQUENCY_5G_LOW, 40);
-        baseStations.emplace_back(4, 1000, 0, FREQUENCY_5G_HIGH, 30);
-        std::cout << "Created " << baseStations.size() << " base stations\n";
+    static Isa& selectedIsa() {
+        static Isa value = detectIsa();
+        return value;
     }
 
-    void createNetworkSlices() {
-        slices.push_back(std::make_shared<NetworkSlice>(1, NetworkSlice::SliceType::eMBB, 0.7, 100));
-        slices.push_back(std::make_shared<NetworkSlice>(2, NetworkSlice::SliceType::URLLC, 0.9, 50));
-        slices.push_back(std::make_shared<NetworkSlice>(3, NetworkSlice::SliceType::mMTC, 0.3, 200));
+    // Cephes-style natural log for positive normal floats.
+    static constexpr float SQRT_HALF = 0.707106781186547524f;
+    static constexpr float LN_POLY[] = {
+            7.0376836292E-2f, -1.1514610310E-1f, 1.1676998740E-1f, -1.2420140846E-1f, 1.4249322787E-1f,
+            -1.6668057665E-1f, 2.0000714765E-1f, -2.4999993993E-1f, 3.3333331174E-1f};
+    static constexpr float LN2_LO = -2.12194440e-4f;
+    static constexpr float LN2_HI = 0.693359375f;
+    static constexpr float LOG10_E = 0.434294481903251828f;
+    static constexpr float NEAR_SLOPE = 11 * LOG10_E;  // 22 log10(d) = 11 log10(d^2)
+    static constexpr float FAR_SLOPE = 20 * LOG10_E;   // 40 log10(d) = 20 log10(d^2)
+    static constexpr float FAR_BREAKPOINT_SLOPE = 9 * LOG10_E;
 
-        for (auto &station: baseStations) {
-            for (auto &slice: slices) {
-                station.addSlice(slice);
-            }
+    static float fastLn(float v) {
+        int32_t bits = std::bit_cast<int32_t>(v);
+        float e = static_cast<float>((bits >> 23) - 126);
+        float m = std::bit_cast<float>((bits & 0x007FFFFF) | 0x3F000000);  // [0.5, 1)
+        bool small = m < SQRT_HALF;
+        e = e - (small ? 1.0f : 0.0f);
+        float t = (m + (small ? m : 0.0f)) - 1.0f;
+        float z = t * t;
+        float p = LN_POLY[0];
+        for (int k = 1; k < 9; ++k) {
+            p = p * t + LN_POLY[k];
         }
-        std::cout << "Created " << slices.size() << " network slices\n";
+        float r = p * t * z;
+        r = r + LN2_LO * e;
+        r = r - 0.5f * z;
+        return (t + r) + LN2_HI * e;
     }
 
-    void createUserEquipment() {
-        std::uniform_real_distribution<double> dist(0, 1000);
-        std::discrete_distribution<int> sliceDist({70, 20, 10});
+    static float rsrpScalar(float ueX, float ueY, const StationBlock& st, size_t s) {
+        float dx = st.x[s] - ueX;
+        float dy = st.y[s] - ueY;
+        float d2 = std::max(dx * dx + dy * dy, 1.0f);
+        float lnD2 = fastLn(d2);
+        float nearLoss = st.pathLossIntercept[s] + NEAR_SLOPE * lnD2;
+        float farLoss = (st.pathLossIntercept[s] + FAR_SLOPE * lnD2) -
+                        FAR_BREAKPOINT_SLOPE * fastLn(st.breakpointSquared[s] + d2);
+        return st.eirp[s] - (d2 < st.breakpointSquared[s] ? nearLoss : farLoss);
+    }
 
-        for (int i = 1; i <= 50; ++i) {
-            NetworkSlice::SliceType type;
-            switch (sliceDist(rng)) {
-                case 0: type = NetworkSlice::SliceType::eMBB; break;
-                case 1: type = NetworkSlice::SliceType::URLLC; break;
-                case 2: type = NetworkSlice::SliceType::mMTC; break;
+    static void measureScalar(const float* ueX, const float* ueY, size_t ueCount,
+                              const StationBlock& stations, size_t begin, size_t end,
+                              float* rsrp, size_t stride, size_t first) {
+        for (size_t u = 0; u < ueCount; ++u) {
+            for (size_t s = first; s < end; ++s) {
+                rsrp[u * stride + (s - begin)] = rsrpScalar(ueX[u], ueY[u], stations, s);
             }
-
-            double bandwidth = 5 + (rand() % 20);
-            ues.emplace_back(i, dist(rng), dist(rng), 1 + (rand() % 5), type, bandwidth);
         }
-        std::cout << "Created " << ues.size() << " user equipment instances\n";
     }
 
-    void displayStatus() {
-        int connected = std::count_if(ues.begin(), ues.end(),
-                                      [](const UserEquipment &ue) { return ue.isConnected(); });
+    static void measureScalar(const float* ueX, const float* ueY, size_t ueCount,
+                              const StationBlock& stations, size_t begin, size_t end,
+                              float* rsrp, size_t stride) {
+        measureScalar(ueX, ueY, ueCount, stations, begin, end, rsrp, stride, begin);
+    }
 
-        std::cout << "Network Status: " << connected << "/" << ues.size()
-                  << " UEs connected (" << (100.0 * connected / ues.size()) << "%)\n";
+#if SIGNAL_KERNEL_X86
+    __attribute__((target("avx2")))
+    static __m256 fastLn(__m256 v) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        __m256i bits = _mm256_castps_si256(v);
+        __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(126)));
+        __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                       _mm256_set1_epi32(0x3F000000)));
+        __m256 small = _mm256_cmp_ps(m, _mm256_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+        e = _mm256_sub_ps(e, _mm256_and_ps(small, one));
+        __m256 t = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(small, m)), one);
+        __m256 z = _mm256_mul_ps(t, t);
+        __m256 p = _mm256_set1_ps(LN_POLY[0]);
+        for (int k = 1; k < 9; ++k) {
+            p = _mm256_add_ps(_mm256_mul_ps(p, t), _mm256_set1_ps(LN_POLY[k]));
+        }
+        __m256 r = _mm256_mul_ps(_mm256_mul_ps(p, t), z);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(LN2_LO), e));
+        r = _mm256_sub_ps(r, _mm256_mul_ps(_mm256_set1_ps(0.5f), z));
+        return _mm256_add_ps(_mm256_add_ps(t, r), _mm256_mul_ps(_mm256_set1_ps(LN2_HI), e));
+    }
 
-        std::map<NetworkSlice::SliceType, int> sliceCounts;
-        for (const auto &ue: ues) {
-            if (ue.isConnected()) {
-                sliceCounts[ue.getRequiredSlice()]++;
+    __attribute__((target("avx2")))
+    static void measureAvx2(const float* ueX, const float* ueY, size_t ueCount,
+                            const StationBlock& st, size_t begin, size_t end,
+                            float* rsrp, size_t stride) {
+        constexpr size_t W = 8;
+        size_t vectorEnd = begin + (end - begin) / W * W;
+        for (size_t u = 0; u < ueCount; ++u) {
+            __m256 ux = _mm256_set1_ps(ueX[u]);
+            __m256 uy = _mm256_set1_ps(ueY[u]);
+            for (size_t s = begin; s < vectorEnd; s += W) {
+                __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(&st.x[s]), ux);
+                __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(&st.y[s]), uy);
+                __m256 d2 = _mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                                          _mm256_set1_ps(1.0f));
+                __m256 intercept = _mm256_loadu_ps(&st.pathLossIntercept[s]);
+                __m256 bp2 = _mm256_loadu_ps(&st.breakpointSquared[s]);
+                __m256 lnD2 = fastLn(d2);
+                __m256 nearLoss = _mm256_add_ps(intercept, _mm256_mul_ps(_mm256_set1_ps(NEAR_SLOPE), lnD2));
+                __m256 farLoss = _mm256_sub_ps(
+                        _mm256_add_ps(intercept, _mm256_mul_ps(_mm256_set1_ps(FAR_SLOPE), lnD2)),
+                        _mm256_mul_ps(_mm256_set1_ps(FAR_BREAKPOINT_SLOPE), fastLn(_mm256_add_ps(bp2, d2))));
+                __m256 loss = _mm256_blendv_ps(farLoss, nearLoss, _mm256_cmp_ps(d2, bp2, _CMP_LT_OQ));
+                _mm256_storeu_ps(&rsrp[u * stride + (s - begin)], _mm256_sub_ps(_mm256_loadu_ps(&st.eirp[s]), loss));
             }
         }
+        if (vectorEnd < end) {
+            measureScalar(ueX, ueY, ueCount, st, begin, end, rsrp, stride, vectorEnd);
+        }
+    }
 
-        std::cout << "Slice Distribution:\n";
-        for (const auto &[type, count]: sliceCounts) {
-            std::string name;
-            switch (type) {
-                case NetworkSlice::SliceType::eMBB: name = "eMBB"; break;
-                case NetworkSlice::SliceType::URLLC: name = "URLLC"; break;
-                case NetworkSlice::SliceType::mMTC: name = "mMTC"; break;
-            }
-            std::cout << "  " << name << ": " << count << " UEs\n";
+    __attribute__((target("avx512f")))
+    static __m512 fastLn(__m512 v) {
+        const __m512 one = _mm512_set1_ps(1.0f);
+        __m512i bits = _mm512_castps_si512(v);
+        __m512 e = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(126)));
+        __m512 m = _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007FFFFF)),
+                                                       _mm512_set1_epi32(0x3F000000)));
+        __mmask16 small = _mm512_cmp_ps_mask(m, _mm512_set1_ps(SQRT_HALF), _CMP_LT_OQ);
+        e = _mm512_sub_ps(e, _mm512_maskz_mov_ps(small, one));
+        __m512 t = _mm512_sub_ps(_mm512_add_ps(m, _mm512_maskz_mov_ps(small, m)), one);
+        __m512 z = _mm512_mul_ps(t, t);
+        __m512 p = _mm512_set1_ps(LN_POLY[0]);
+        for (int k = 1; k < 9; ++k) {
+            p = _mm512_add_ps(_mm512_mul_ps(p, t), _mm512_set1_ps(LN_POLY[k]));
         }
+        __m512 r = _mm512_mul_ps(_mm512_mul_ps(p, t), z);
+        r = _mm512_add_ps(r, _mm512_mul_ps(_mm512_set1_ps(LN2_LO), e));
+        r = _mm512_sub_ps(r, _mm512_mul_ps(_mm512_set1_ps(0.5f), z));
+        return _mm512_add_ps(_mm512_add_ps(t, r), _mm512_mul_ps(_mm512_set1_ps(LN2_HI), e));
     }
 
-    std::vector<BaseStation> baseStations;
-    std::vector<std::shared_ptr<NetworkSlice>> slices;
-    std::vector<UserEquipment> ues;
-    std::mt19937 rng;
+    __attribute__((target("avx512f")))
+    static void measureAvx512(const float* ueX, const float* ueY, size_t ueCount,
+                              const StationBlock& st, size_t begin, size_t end,
+                              float* rsrp, size_t stride) {
+        constexpr size_t W = 16;
+        size_t vectorEnd = begin + (end - begin) / W * W;
+        for (size_t u = 0; u < ueCount; ++u) {
+            __m512 ux = _mm512_set1_ps(ueX[u]);
+            __m512 uy = _mm512_set1_ps(ueY[u]);
+            for (size_t s = begin; s < vectorEnd; s += W) {
+                __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(&st.x[s]), ux);
+                __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(&st.y[s]), uy);
+                __m512 d2 = _mm512_max_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)),
+                                          _mm512_set1_ps(1.0f));
+                __m512 intercept = _mm512_loadu_ps(&st.pathLossIntercept[s]);
+                __m512 bp2 = _mm512_loadu_ps(&st.breakpointSquared[s]);
+                __m512 lnD2 = fastLn(d2);
+                __m512 nearLoss = _mm512_add_ps(intercept, _mm512_mul_ps(_mm512_set1_ps(NEAR_SLOPE), lnD2));
+                __m512 farLoss = _mm512_sub_ps(
+                        _mm512_add_ps(intercept, _mm512_mul_ps(_mm512_set1_ps(FAR_SLOPE), lnD2)),
+                        _mm512_mul_ps(_mm512_set1_ps(FAR_BREAKPOINT_SLOPE), fastLn(_mm512_add_ps(bp2, d2))));
+                __m512 loss = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(d2, bp2, _CMP_LT_OQ), farLoss, nearLoss);
+                _mm512_storeu_ps(&rsrp[u * stride + (s - begin)], _mm512_sub_ps(_mm512_loadu_ps(&st.eirp[s]), loss));
+            }
+        }
+        if (vectorEnd < end) {
+            measureScalar(ueX, ueY, ueCount, st, begin, end, rsrp, stride, vectorEnd);
+        }
+    }
+#endif
 };
 
-int main() {
-    FiveGNetwork network;
+// Link-to-system abstraction: SINR to CQI, MCS and spectral efficiency using
+// the 256QAM tables of 3GPP TS 38.214 (CQI Table 5.2.2.1-3, MCS Table
+// 5.1.3.1-2). An entry's SINR threshold is where attenuated Shannon,
+// 0.75 log2(1 + SINR), reaches its efficiency; this stands in for the 10%
+// BLER points of link-level curves. Everything is resampled at compile time
+// onto a 0.1 dB grid, so a lookup is one multiply and two loads.
+class LinkAbstraction {
+public:
+    struct TableEntry {
+        uint8_t modulationOrder;  // bits per symbol
+        float codeRate;           // x1024
+        float efficiency;         // bits/s/Hz
+        float sinrThreshold;      // dB
+    };
+
+    // Index 0 is CQI 1; CQI 0 means out of range
+    static constexpr std::array<TableEntry, 15> CQI_TABLE = {{
+            {2, 78, 0.1523f, -8.21f}, {2, 193, 0.3770f, -3.80f}, {2, 449, 0.8770f, 0.97f},
+            {4, 378, 1.4766f, 4.65f}, {4, 490, 1.9141f, 6.87f}, {4, 616, 2.4063f, 9.16f},
+            {6, 466, 2.7305f, 10.60f}, {6, 567, 3.3223f, 13.13f}, {6, 666, 3.9023f, 15.54f},
+            {6, 772, 4.5234f, 18.09f}, {6, 873, 5.1152f, 20.49f}, {8, 711, 5.5547f, 22.27f},
+            {8, 797, 6.2266f, 24.98f}, {8, 885, 6.9141f, 27.74f}, {8, 948, 7.4063f, 29.72f}
+    }};
+
+    static constexpr std::array<TableEntry, 28> MCS_TABLE = {{
+            {2, 120, 0.2344f, -6.16f}, {2, 193, 0.3770f, -3.80f}, {2, 308, 0.6016f, -1.29f},
+            {2, 449, 0.8770f, 0.97f}, {2, 602, 1.1758f, 2.93f}, {4, 378, 1.4766f, 4.65f},
+            {4, 434, 1.6953f, 5.79f}, {4, 490, 1.9141f, 6.87f}, {4, 553, 2.1602f, 8.04f},
+            {4, 616, 2.4063f, 9.16f}, {4, 658, 2.5703f, 9.89f}, {6, 466, 2.7305f, 10.60f},
+            {6, 517, 3.0293f, 11.89f}, {6, 567, 3.3223f, 13.13f}, {6, 616, 3.6094f, 14.33f},
+            {6, 666, 3.9023f, 15.54f}, {6, 719, 4.2129f, 16.82f}, {6, 772, 4.5234f, 18.09f},
+            {6, 822, 4.8164f, 19.28f}, {6, 873, 5.1152f, 20.49f}, {8, 682.5f, 5.3320f, 21.37f},
+            {8, 711, 5.5547f, 22.27f}, {8, 754, 5.8906f, 23.62f}, {8, 797, 6.2266f, 24.98f},
+            {8, 841, 6.5703f, 26.36f}, {8, 885, 6.9141f, 27.74f}, {8, 916.5f, 7.1602f, 28.73f},
+            {8, 948, 7.4063f, 29.72f}
+    }};
+
+    static constexpr float MIN_SINR_DB = -10.0f;
+    static constexpr float MAX_SINR_DB = 32.0f;
+    static constexpr float GRID_STEP_DB = 0.1f;
+    static constexpr size_t GRID_SIZE =
+            static_cast<size_t>((MAX_SINR_DB - MIN_SINR_DB) / GRID_STEP_DB + 1.5f);
+
+    // Highest CQI (1-15) whose threshold the SINR meets, or 0
+    static int cqi(float sinrDb) { return GRID[gridIndex(sinrDb)].cqi; }
+
+    // Highest MCS (0-27) whose threshold the SINR meets, or -1 when not even
+    // MCS 0 can be decoded
+    static int mcs(float sinrDb) { return GRID[gridIndex(sinrDb)].mcs; }
+
+    // Bits/s/Hz, linear through the MCS thresholds (link adaptation fills
+    // in between the table steps); 0 below MCS 0, capped at MCS 27.
+    static float spectralEfficiency(float sinrDb) {
+        float position = std::clamp((sinrDb - MIN_SINR_DB) * (1 / GRID_STEP_DB), 0.0f,
+                                    static_cast<float>(GRID_SIZE - 1));
+        size_t index = std::min(static_cast<size_t>(position), GRID_SIZE - 2);
+        float fraction = position - static_cast<float>(index);
+        return GRID[index].efficiency + fraction * (GRID[index + 1].efficiency - GRID[index].efficiency);
+    }
+
+private:
+    struct GridPoint {
+        float efficiency;
+        uint8_t cqi;
+        int8_t mcs;
+    };
+
+    static size_t gridIndex(float sinrDb) {
+        float position = std::clamp((sinrDb - MIN_SINR_DB) * (1 / GRID_STEP_DB), 0.0f,
+                                    static_cast<float>(GRID_SIZE - 1));
+        return static_cast<size_t>(position);
+    }
+
+    static constexpr std::array<GridPoint, GRID_SIZE> GRID = [] {
+        std::array<GridPoint, GRID_SIZE> grid{};
+        for (size_t i = 0; i < GRID_SIZE; ++i) {
+            float sinr = MIN_SINR_DB + GRID_STEP_DB * static_cast<float>(i);
+            GridPoint& point = grid[i];
+            point.mcs = -1;
+            for (size_t m = 0; m < MCS_TABLE.size() && MCS_TABLE[m].sinrThreshold <= sinr; ++m) {
+                point.mcs = static_cast<int8_t>(m);
+            }
+            for (size_t c = 0; c < CQI_TABLE.size() && CQI_TABLE[c].sinrThreshold <= sinr; ++c) {
+                point.cqi = static_cast<uint8_t>(c + 1);
+            }
+            if (point.mcs < 0) {
+                point.efficiency = 0;
+            } else if (static_cast<size_t>(point.mcs) + 1 == MCS_TABLE.size()) {
+                point.efficiency = MCS_TABLE.back().efficiency;
+            } else {
+                const TableEntry& lo = MCS_TABLE[point.mcs];
+                const TableEntry& hi = MCS_TABLE[point.mcs + 1];
+                point.efficiency = lo.efficiency + (sinr - lo.sinrThreshold) *
+                                   (hi.efficiency - lo.efficiency) / (hi.sinrThreshold - lo.sinrThreshold);
+            }
+        }
+        return grid;
+    }();
+};
+
+// Per-UE events (attach, release, handover, link failure) as fixed-size
+// binary records. With a file open, record() copies into a lock-free
+// single-producer ring owned by the calling thread and a background writer
+// drains every ring to disk, so the simulation never formats text or waits
+// on I/O; the --decode-log mode renders the file offline as the same text
+// the simulator prints without a log. Without a file, records are rendered
+// straight to std::cout. Records from one thread keep their order.
+class EventLog {
+public:
+    enum class Kind : uint8_t {
+        Connected,          // station, slice, sinr, rsrp, allocated, required
+        AllocationFailed,   // slice
+        CandidateRejected,  // best candidate's sinr, rsrp; value = its available MHz
+        NoViableStation,    // attempt
+        Disconnected,
+        HandedOver,         // station -> target; rsrp -> value (target RSRP)
+        HandoverFailed,     // target, slice
+        RadioLinkFailure    // sinr
+    };
+
+    struct Record {
+        double time = 0;        // simulated seconds, stamped by record()
+        double sinr = 0;        // dB
+        double rsrp = 0;        // dBm
+        double value = 0;       // kind-specific, see Kind
+        double allocated = 0;   // MHz
+        float required = 0;     // MHz
+        uint32_t ue = 0;
+        int32_t station = 0;    // gNB ids, not handles, so the file outlives the run
+        int32_t target = 0;
+        Kind kind = Kind::Connected;
+        NetworkSlice::SliceType slice = NetworkSlice::SliceType::eMBB;
+        uint8_t attempt = 0;
+        uint8_t reserved = 0;
+    };
+    static_assert(sizeof(Record) == 64, "records are written to disk as-is");
+
+    EventLog() = default;
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+    ~EventLog() { close(); }
+
+    // Starts the writer thread; false if the file cannot be created, in
+    // which case records keep going to std::cout.
+    bool open(const std::string& path) {
+        close();
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        FileHeader header;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        stopping.store(false, std::memory_order_relaxed);
+        writer = std::thread([this] { drainLoop(); });
+        return true;
+    }
+
+    // Writes out everything recorded so far and stops the writer. Every
+    // producer thread must be done recording.
+    void close() {
+        if (!writer.joinable()) return;
+        stopping.store(true, std::memory_order_release);
+        writer.join();
+        file.close();
+    }
+
+    // Simulated time stamped on subsequent records; set between event batches
+    void setClock(double time) { clock = time; }
+
+    void record(Record event) {
+        event.time = clock;
+        if (!writer.joinable()) {
+            render(std::cout, event);
+            return;
+        }
+        Ring& ring = localRing();
+        size_t head = ring.head.load(std::memory_order_relaxed);
+        while (head - ring.tail.load(std::memory_order_acquire) == Ring::CAPACITY) {
+            std::this_thread::yield();  // full: wait for the writer rather than drop
+        }
+        ring.slots[head % Ring::CAPACITY] = event;
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+
+    static void render(std::ostream& out, const Record& event) {
+        std::string slice = NetworkSlice::typeName(event.slice);
+        out << "UE " << event.ue;
+        switch (event.kind) {
+            case Kind::Connected:
+                out << " connected to gNB " << event.station << " on " << slice << " slice\n"
+                    << "  - Allocated BW: " << event.allocated << "/" << event.required << " MHz\n"
+                    << "  - SINR: " << event.sinr << " dB, RSRP: " << event.rsrp << " dBm\n"
+                    << "  - CQI: " << LinkAbstraction::cqi(static_cast<float>(event.sinr))
+                    << ", MCS: " << LinkAbstraction::mcs(static_cast<float>(event.sinr))
+                    << ", Link Rate: "
+                    << event.allocated * LinkAbstraction::spectralEfficiency(static_cast<float>(event.sinr))
+                    << " Mbps\n";
+                break;
+            case Kind::AllocationFailed:
+                out << " failed to allocate resources on " << slice << " slice\n";
+                break;
+            case Kind::CandidateRejected:
+                out << " could not connect (Best Candidate: SINR " << event.sinr << " dB, RSRP " << event.rsrp
+                    << " dBm, BW " << event.value << " MHz)\n";
+                break;
+            case Kind::NoViableStation:
+                out << " found no viable stations (Attempt " << static_cast<int>(event.attempt) << ")\n";
+                break;
+            case Kind::Disconnected:
+                out << " disconnected\n";
+                break;
+            case Kind::HandedOver:
+                out << " handed over from gNB " << event.station << " to gNB " << event.target
+                    << " (RSRP " << event.rsrp << " -> " << event.value << " dBm)\n";
+                break;
+            case Kind::HandoverFailed:
+                out << " handover to gNB " << event.target << " failed: no capacity on " << slice << " slice\n";
+                break;
+            case Kind::RadioLinkFailure:
+                out << " radio link failure (SINR " << event.sinr << " dB)\n";
+                break;
+        }
+    }
+
+    // Offline decoder: renders a log file, with a step banner whenever the
+    // records cross into a new simulation step. False if the file is
+    // missing or was written by an incompatible build.
+    static bool decode(const std::string& path, std::ostream& out) {
+        std::ifstream in(path, std::ios::binary);
+        FileHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0 ||
+            header.version != FileHeader{}.version || header.recordSize != sizeof(Record)) {
+            return false;
+        }
+        Record event;
+        int64_t step = -1;
+        while (in.read(reinterpret_cast<char*>(&event), sizeof(event))) {
+            // Same tick arithmetic as the simulator's own step count
+            int64_t eventStep = std::llround(event.time * TICKS_PER_SECOND) /
+                                std::llround(header.stepDuration * TICKS_PER_SECOND);
+            if (eventStep != step) {
+                step = eventStep;
+                out << "\n=== Simulation Step " << step + 1 << " ===\n";
+            }
+            render(out, event);
+        }
+        return true;
+    }
+
+private:
+    struct FileHeader {
+        char magic[8] = {'5', 'G', 'E', 'V', 'L', 'O', 'G', '\0'};
+        uint32_t version = 1;
+        uint32_t recordSize = sizeof(Record);
+        double stepDuration = STEP_DURATION;
+    };
+
+    struct Ring {
+        static constexpr size_t CAPACITY = 4096;
+        std::array<Record, CAPACITY> slots;
+        alignas(64) std::atomic<size_t> head{0};  // written by the producer
+        alignas(64) std::atomic<size_t> tail{0};  // written by the writer
+    };
+
+    // The calling thread's ring, registered on first use. Keyed by instance
+    // id rather than address, so a new log never reuses a stale ring.
+    Ring& localRing() {
+        thread_local uint64_t owner = 0;
+        thread_local Ring* ring = nullptr;
+        if (owner != instanceId) {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(std::make_unique<Ring>());
+            ring = rings.back().get();
+            owner = instanceId;
+        }
+        return *ring;
+    }
+
+    void drainLoop() {
+        std::vector<Ring*> snapshot;
+        while (true) {
+            // Sampled before draining, so a drain that finds nothing after a
+            // stop request has seen every record made before close()
+            bool stop = stopping.load(std::memory_order_acquire);
+            {
+                std::lock_guard<std::mutex> lock(ringsMutex);
+                snapshot.clear();
+                for (auto& ring : rings) snapshot.push_back(ring.get());
+            }
+            size_t drained = 0;
+            for (Ring* ring : snapshot) {
+                size_t tail = ring->tail.load(std::memory_order_relaxed);
+                size_t head = ring->head.load(std::memory_order_acquire);
+                for (size_t n = tail; n < head;) {
+                    size_t first = n % Ring::CAPACITY;
+                    size_t count = std::min(head - n, Ring::CAPACITY - first);
+                    file.write(reinterpret_cast<const char*>(&ring->slots[first]),
+                               static_cast<std::streamsize>(count * sizeof(Record)));
+                    n += count;
+                }
+                ring->tail.store(head, std::memory_order_release);
+                drained += head - tail;
+            }
+            if (drained == 0) {
+                if (stop) break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        file.flush();
+    }
+
+    static inline std::atomic<uint64_t> nextInstanceId{1};
+
+    const uint64_t instanceId = nextInstanceId++;
+    double clock = 0;
+    std::ofstream file;
+    std::thread writer;
+    std::atomic<bool> stopping{false};
+    std::mutex ringsMutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+};
+
+// Per-step KPI time series as a columnar binary file. Rows are buffered per
+// column and written out in chunks, every column one contiguous 64-byte
+// aligned array, so analysis tools can mmap the file and use a column in
+// place. A footer indexes each chunk's column offsets and the trailer at the
+// very end locates the footer. With compression, integer columns are stored
+// as zigzag varint deltas; float columns always stay raw and mappable.
+class KpiFile {
+public:
+    enum class ColumnType : uint32_t {
+        UInt32, Int32, Float32
+    };
+
+    enum class Encoding : uint32_t {
+        Raw, DeltaVarint
+    };
+
+    // One row per (step, cell, slice). gNB 0 collects attach attempts that
+    // found no station; SINR statistics are NaN where no UE is connected.
+    struct Row {
+        uint32_t step = 0;
+        int32_t gnb = 0;
+        NetworkSlice::SliceType slice = NetworkSlice::SliceType::eMBB;
+        uint32_t connected = 0;
+        uint32_t attachAttempts = 0;
+        uint32_t attachFailures = 0;
+        uint32_t handovers = 0;          // out of this cell
+        uint32_t handoverFailures = 0;
+        uint32_t radioLinkFailures = 0;
+        float sinrMean = 0, sinrP5 = 0, sinrP50 = 0, sinrP95 = 0;  // dB
+        float allocatedMhz = 0, capacityMhz = 0;
+    };
+
+    static constexpr size_t COLUMN_COUNT = 15;
+    static constexpr uint32_t CHUNK_ROWS = 65536;
+
+    KpiFile() = default;
+    KpiFile(const KpiFile&) = delete;
+    KpiFile& operator=(const KpiFile&) = delete;
+    ~KpiFile() { close(); }
+
+    bool open(const std::string& path, bool compressIntegers) {
+        close();
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        compress = compressIntegers;
+        chunks.clear();
+        offset = 0;
+        rowCount = 0;
+
+        FileHeader header;
+        header.flags = compress ? 1 : 0;
+        write(&header, sizeof(header));
+        for (const ColumnInfo& column : COLUMNS) {
+            ColumnDescriptor descriptor{};
+            std::copy(column.name.begin(), column.name.end(), descriptor.name);
+            descriptor.type = column.type;
+            write(&descriptor, sizeof(descriptor));
+        }
+        return true;
+    }
+
+    bool isOpen() const { return file.is_open(); }
+
+    void append(const Row& row) {
+        const std::array<uint32_t, COLUMN_COUNT> words = {
+                row.step, std::bit_cast<uint32_t>(row.gnb), static_cast<uint32_t>(row.slice), row.connected,
+                row.attachAttempts, row.attachFailures, row.handovers, row.handoverFailures,
+                row.radioLinkFailures, std::bit_cast<uint32_t>(row.sinrMean), std::bit_cast<uint32_t>(row.sinrP5),
+                std::bit_cast<uint32_t>(row.sinrP50), std::bit_cast<uint32_t>(row.sinrP95),
+                std::bit_cast<uint32_t>(row.allocatedMhz), std::bit_cast<uint32_t>(row.capacityMhz)
+        };
+        for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+            columns[c].push_back(words[c]);
+        }
+        if (columns[0].size() == CHUNK_ROWS) {
+            flushChunk();
+        }
+    }
+
+    // Writes the last partial chunk, the footer and the trailer
+    void close() {
+        if (!file.is_open()) return;
+        flushChunk();
+        uint64_t footerOffset = offset;
+        for (const ChunkEntry& chunk : chunks) {
+            write(&chunk, sizeof(chunk));
+        }
+        Trailer trailer;
+        trailer.footerOffset = footerOffset;
+        trailer.chunkCount = chunks.size();
+        trailer.rowCount = rowCount;
+        write(&trailer, sizeof(trailer));
+        file.close();
+    }
+
+    // Prints a KPI file as CSV; false if it is not a complete KPI file
+    static bool dump(const std::string& path, std::ostream& out) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        FileHeader header;
+        Trailer trailer;
+        if (bytes.size() < sizeof(header) + sizeof(trailer)) return false;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        std::memcpy(&trailer, bytes.data() + bytes.size() - sizeof(trailer), sizeof(trailer));
+        if (std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0 ||
+            std::memcmp(trailer.magic, Trailer{}.magic, sizeof(trailer.magic)) != 0 ||
+            header.version != FileHeader{}.version || header.columnCount != COLUMN_COUNT ||
+            trailer.footerOffset + trailer.chunkCount * sizeof(ChunkEntry) + sizeof(trailer) != bytes.size()) {
+            return false;
+        }
+
+        for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+            out << (c ? "," : "") << COLUMNS[c].name;
+        }
+        out << "\n";
+        std::array<std::vector<uint32_t>, COLUMN_COUNT> values;
+        for (uint64_t k = 0; k < trailer.chunkCount; ++k) {
+            ChunkEntry chunk;
+            std::memcpy(&chunk, bytes.data() + trailer.footerOffset + k * sizeof(ChunkEntry), sizeof(chunk));
+            for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+                const ColumnEntry& entry = chunk.columns[c];
+                if (entry.offset + entry.bytes > trailer.footerOffset) return false;
+                values[c].resize(chunk.rowCount);
+                const auto* data = reinterpret_cast<const uint8_t*>(bytes.data() + entry.offset);
+                if (entry.encoding == Encoding::Raw) {
+                    if (entry.bytes != chunk.rowCount * sizeof(uint32_t)) return false;
+                    std::memcpy(values[c].data(), data, entry.bytes);
+                } else if (!decodeDeltas(data, entry.bytes, values[c])) {
+                    return false;
+                }
+            }
+            for (size_t r = 0; r < chunk.rowCount; ++r) {
+                for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+                    out << (c ? "," : "");
+                    switch (COLUMNS[c].type) {
+                        case ColumnType::UInt32: out << values[c][r]; break;
+                        case ColumnType::Int32: out << std::bit_cast<int32_t>(values[c][r]); break;
+                        case ColumnType::Float32: out << std::bit_cast<float>(values[c][r]); break;
+                    }
+                }
+                out << "\n";
+            }
+        }
+        return true;
+    }
+
+private:
+    struct ColumnInfo {
+        std::string_view name;
+        ColumnType type;
+    };
+
+    static constexpr std::array<ColumnInfo, COLUMN_COUNT> COLUMNS = {{
+            {"step", ColumnType::UInt32}, {"gnb", ColumnType::Int32}, {"slice", ColumnType::UInt32},
+            {"connected", ColumnType::UInt32}, {"attach_attempts", ColumnType::UInt32},
+            {"attach_failures", ColumnType::UInt32}, {"handovers", ColumnType::UInt32},
+            {"handover_failures", ColumnType::UInt32}, {"radio_link_failures", ColumnType::UInt32},
+            {"sinr_mean_db", ColumnType::Float32}, {"sinr_p5_db", ColumnType::Float32},
+            {"sinr_p50_db", ColumnType::Float32}, {"sinr_p95_db", ColumnType::Float32},
+            {"allocated_mhz", ColumnType::Float32}, {"capacity_mhz", ColumnType::Float32}
+    }};
+
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct FileHeader {
+        char magic[8] = {'5', 'G', 'K', 'P', 'I', '\0', '\0', '\0'};
+        uint32_t version = 1;
+        uint32_t columnCount = COLUMN_COUNT;
+        uint32_t chunkRows = CHUNK_ROWS;
+        uint32_t flags = 0;  // bit 0: integer columns compressed
+    };
+
+    struct ColumnDescriptor {
+        char name[28];
+        ColumnType type;
+    };
+
+    struct ColumnEntry {
+        uint64_t offset;  // from the start of the file
+        uint32_t bytes;
+        Encoding encoding;
+    };
+
+    struct ChunkEntry {
+        uint64_t firstRow;
+        uint64_t rowCount;
+        std::array<ColumnEntry, COLUMN_COUNT> columns;
+    };
+
+    struct Trailer {
+        uint64_t footerOffset = 0;
+        uint64_t chunkCount = 0;
+        uint64_t rowCount = 0;
+        char magic[8] = {'5', 'G', 'K', 'P', 'I', 'E', 'N', 'D'};
+    };
+
+    void write(const void* data, size_t bytes) {
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        offset += bytes;
+    }
+
+    void flushChunk() {
+        size_t rows = columns[0].size();
+        if (rows == 0) return;
+        ChunkEntry chunk{rowCount, rows, {}};
+        std::vector<uint8_t> encoded;
+        for (size_t c = 0; c < COLUMN_COUNT; ++c) {
+            static constexpr std::array<char, ALIGNMENT> padding{};
+            write(padding.data(), (ALIGNMENT - offset % ALIGNMENT) % ALIGNMENT);
+            chunk.columns[c].offset = offset;
+            if (compress && COLUMNS[c].type != ColumnType::Float32) {
+                encodeDeltas(columns[c], COLUMNS[c].type, encoded);
+                chunk.columns[c].encoding = Encoding::DeltaVarint;
+                chunk.columns[c].bytes = static_cast<uint32_t>(encoded.size());
+                write(encoded.data(), encoded.size());
+            } else {
+                chunk.columns[c].encoding = Encoding::Raw;
+                chunk.columns[c].bytes = static_cast<uint32_t>(rows * sizeof(uint32_t));
+                write(columns[c].data(), rows * sizeof(uint32_t));
+            }
+            columns[c].clear();
+        }
+        chunks.push_back(chunk);
+        rowCount += rows;
+    }
+
+    // Each value minus its predecessor (the first minus 0), zigzagged so
+    // small negative steps stay short, as LEB128 varints
+    static void encodeDeltas(const std::vector<uint32_t>& values, ColumnType type, std::vector<uint8_t>& out) {
+        out.clear();
+        int64_t previous = 0;
+        for (uint32_t word : values) {
+            int64_t value = type == ColumnType::Int32 ? std::bit_cast<int32_t>(word) : int64_t{word};
+            int64_t delta = value - previous;
+            previous = value;
+            uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+            do {
+                out.push_back(static_cast<uint8_t>((zigzag & 0x7F) | (zigzag > 0x7F ? 0x80 : 0)));
+                zigzag >>= 7;
+            } while (zigzag);
+        }
+    }
+
+    static bool decodeDeltas(const uint8_t* data, size_t bytes, std::vector<uint32_t>& values) {
+        int64_t previous = 0;
+        size_t position = 0;
+        for (uint32_t& word : values) {
+            uint64_t zigzag = 0;
+            for (int shift = 0;; shift += 7) {
+                if (position == bytes || shift > 63) return false;
+                uint8_t byte = data[position++];
+                zigzag |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) break;
+            }
+            previous += static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+            word = static_cast<uint32_t>(previous);
+        }
+        return position == bytes;
+    }
+
+    std::ofstream file;
+    uint64_t offset = 0;
+    uint64_t rowCount = 0;
+    bool compress = false;
+    std::array<std::vector<uint32_t>, COLUMN_COUNT> columns;
+    std::vector<ChunkEntry> chunks;
+};
+
+// A per-UE attribute that never changes once the UE exists. It either owns
+// its values, as when UEs are drawn one by one, or aliases values that
+// owner keeps alive, such as a column of a mapped scenario, so a large
+// population is used where it lies instead of being copied. Appending to an
+// aliased column copies it first.
+template <typename T>
+class ReadOnlyColumn {
+public:
+    using value_type = T;
+
+    void alias(const T* values, size_t count, std::shared_ptr<const void> keepAlive) {
+        owned.clear();
+        data = values;
+        length = count;
+        owner = std::move(keepAlive);
+    }
+
+    void append(const T* values, size_t count) {
+        own();
+        owned.insert(owned.end(), values, values + count);
+        refresh();
+    }
+
+    void push_back(const T& value) {
+        own();
+        owned.push_back(value);
+        refresh();
+    }
+
+    void reserve(size_t count) {
+        own();
+        owned.reserve(count);
+        refresh();
+    }
+
+    size_t size() const { return length; }
+    const T& operator[](size_t i) const { return data[i]; }
+
+private:
+    void own() {
+        if (owner) {
+            owned.assign(data, data + length);
+            owner.reset();
+        }
+    }
+
+    void refresh() {
+        data = owned.data();
+        length = owned.size();
+    }
+
+    std::vector<T> owned;
+    const T* data = nullptr;
+    size_t length = 0;
+    std::shared_ptr<const void> owner;
+};
+
+// Structure-of-arrays UE population. Every attribute lives in its own
+// contiguous column indexed by UE slot, so per-step sweeps (movement, signal
+// evaluation, status counts) stream through only the columns they touch.
+// The UE id of slot i is i + 1. Stations and slices are referenced by
+// SlotMap handles, so they may come and go without leaving dangling references.
+class UserEquipmentStore {
+public:
+    struct SliceRequirements {
+        double minSinr;
+        double minRsrp;
+        double bandwidthPriority;
+    };
+
+    // Indexed by SliceType
+    using SliceRequirementTable = std::array<SliceRequirements, NetworkSlice::TYPE_COUNT>;
+
+    static constexpr SliceRequirementTable DEFAULT_SLICE_REQUIREMENTS = {{
+            {5.0, -110.0, 0.7},   // eMBB
+            {10.0, -105.0, 0.9},  // URLLC
+            {0.0, -120.0, 0.3}    // mMTC
+    }};
+
+    // A3 event: a neighbour becomes offset better than the serving cell.
+    // Entered when Mn - hysteresis > Ms + offset, left when
+    // Mn + hysteresis < Ms + offset; a handover fires once the event has held
+    // for timeToTrigger (RSRP in dB, time in simulated seconds). Reports come
+    // once per mobility step, so the timer is only checked at step
+    // boundaries: any timeToTrigger up to STEP_DURATION fires on the next
+    // report that still satisfies entry, and longer ones round up to whole
+    // steps. T310 is observed the same way.
+    struct HandoverParameters {
+        static constexpr double MAX_OFFSET = 15.0;          // dB; the RRC range for both
+        static constexpr double MAX_TIME_TO_TRIGGER = 5.12;  // s; the largest RRC value
+
+        double a3Offset = 3.0;
+        double hysteresis = 1.0;
+        double timeToTrigger = 0.64;
+
+        bool valid() const {
+            return a3Offset >= -MAX_OFFSET && a3Offset <= MAX_OFFSET && hysteresis >= 0 &&
+                   hysteresis <= MAX_OFFSET && timeToTrigger >= 0 && timeToTrigger <= MAX_TIME_TO_TRIGGER;
+        }
+    };
+
+    // What a connected UE measured on its serving cell and neighbour list
+    struct MeasurementReport {
+        BaseStation::SignalMetrics serving{};
+        BaseStation::SignalMetrics neighbour{};  // strongest neighbour by RSRP
+        StationHandle neighbourStation;
+        SliceHandle neighbourSlice;              // the UE's slice type on that neighbour
+        bool valid = false;
+    };
+
+    enum class HandoverOutcome {
+        None, HandedOver, Failed, RadioLinkFailure
+    };
+
+    // Cache keys: a connected UE measures its serving cell (a block position)
+    // and neighbour list, an attach the stations around it. An attach
+    // measurement is reused wherever the UE is until it has moved the
+    // refresh distance, since every station it can hear lies in the grid
+    // neighbourhood on either side of a cell edge. Block positions fit a
+    // SlotHandle index, which leaves the top bit for SERVING_KEY.
+    static constexpr uint32_t NO_MEASUREMENT = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t SERVING_KEY = 1u << 31;
+    static constexpr uint32_t ATTACH_KEY = 0;
+    static constexpr uint32_t NO_MEMBER = SERVING_KEY - 1;
+
+    static uint32_t servingKey(uint32_t servingPosition) { return SERVING_KEY | servingPosition; }
+
+    struct ConnectionCandidate {
+        StationHandle station;
+        SliceHandle slice;
+        double sinr = -std::numeric_limits<double>::infinity();
+        double rsrp = -std::numeric_limits<double>::infinity();
+        double availableBandwidth = 0;
+
+        bool isViable() const {
+            return station.isValid() && slice.isValid();
+        }
+
+        double score() const {
+            return 0.7 * sinr + 0.2 * rsrp + 0.1 * availableBandwidth;
+        }
+    };
+
+    // Streaming best-K selection: each candidate is scored once as it is
+    // offered and the K best are kept best-first in an inline buffer, so an
+    // attach proposal neither allocates nor sorts. The runners-up serve as
+    // fallbacks at commit time if the best slice has been drained meanwhile.
+    class CandidateShortlist {
+    public:
+        static constexpr size_t CAPACITY = 3;
+
+        void offer(const ConnectionCandidate& candidate) {
+            double score = candidate.score();
+            if (count == CAPACITY && score <= scores[CAPACITY - 1]) return;
+
+            size_t pos = std::min(count, CAPACITY - 1);
+            while (pos > 0 && scores[pos - 1] < score) {
+                entries[pos] = entries[pos - 1];
+                scores[pos] = scores[pos - 1];
+                --pos;
+            }
+            entries[pos] = candidate;
+            scores[pos] = score;
+            count = std::min(count + 1, CAPACITY);
+        }
+
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+        const ConnectionCandidate& operator[](size_t k) const { return entries[k]; }
+
+        // The top candidate, or a non-viable placeholder when nothing qualified
+        ConnectionCandidate best() const { return count ? entries[0] : ConnectionCandidate{}; }
+
+    private:
+        std::array<ConnectionCandidate, CAPACITY> entries{};
+        std::array<double, CAPACITY> scores{};
+        size_t count = 0;
+    };
+
+    void reserve(size_t count) {
+        x.reserve(count);
+        y.reserve(count);
+        speed.reserve(count);
+        requiredSlice.reserve(count);
+        requiredBandwidth.reserve(count);
+        grantedUnits.reserve(count);
+        currentSignal.reserve(count);
+        servingStation.reserve(count);
+        connectionAttempts.reserve(count);
+        handoverTarget.reserve(count);
+        handoverEnteredStep.reserve(count);
+        outOfSyncStep.reserve(count);
+        measuredX.reserve(count);
+        measuredY.reserve(count);
+        radioDirty.reserve(count);
+        measurementCache.reserve(count);
+    }
+
+    void add(double ueX, double ueY, double ueSpeed,
+             NetworkSlice::SliceType slice, double bandwidth) {
+        materialize();
+        x.push_back(static_cast<float>(ueX));
+        y.push_back(static_cast<float>(ueY));
+        speed.push_back(static_cast<float>(ueSpeed));
+        requiredSlice.push_back(slice);
+        requiredBandwidth.push_back(static_cast<float>(bandwidth));
+        grantedUnits.push_back(0);
+        currentSignal.push_back(0);
+        servingStation.push_back(StationHandle{});
+        connectionAttempts.push_back(0);
+        handoverTarget.push_back(StationHandle{});
+        handoverEnteredStep.push_back(0);
+        outOfSyncStep.push_back(IN_SYNC);
+        measuredX.push_back(static_cast<float>(ueX));
+        measuredY.push_back(static_cast<float>(ueY));
+        radioDirty.push_back(1);
+        measurementCache.emplace_back();
+    }
+
+    // Appends count UEs from ready-made columns, e.g. straight out of a
+    // mapped binary scenario that owner keeps alive. Into an empty store the
+    // read-only columns are aliased rather than copied, and the mutable ones
+    // are left for materialize(), so loading a population allocates nothing
+    // per UE until the simulation needs it.
+    void addColumns(const double* ueX, const double* ueY, const float* ueSpeed,
+                    const NetworkSlice::SliceType* slice, const float* bandwidth, size_t count,
+                    std::shared_ptr<const void> owner) {
+        materialize();
+        if (size() == 0) {
+            speed.alias(ueSpeed, count, owner);
+            requiredSlice.alias(slice, count, owner);
+            requiredBandwidth.alias(bandwidth, count, owner);
+        } else {
+            speed.append(ueSpeed, count);
+            requiredSlice.append(slice, count);
+            requiredBandwidth.append(bandwidth, count);
+        }
+        pendingX = ueX;
+        pendingY = ueY;
+        pendingOwner = std::move(owner);
+    }
+
+    // Allocates the per-UE state of UEs added by addColumns() since the last
+    // call, starting them where the columns place them. Every other member
+    // assumes it has run; call before the simulation starts.
+    void materialize() {
+        size_t first = x.size();
+        size_t total = size();
+        if (first == total) return;
+
+        x.resize(total);
+        y.resize(total);
+        for (size_t i = first; i < total; ++i) {
+            x[i] = static_cast<float>(pendingX[i - first]);
+            y[i] = static_cast<float>(pendingY[i - first]);
+        }
+        grantedUnits.resize(total, 0);
+        currentSignal.resize(total, 0);
+        servingStation.resize(total, StationHandle{});
+        connectionAttempts.resize(total, 0);
+        handoverTarget.resize(total, StationHandle{});
+        handoverEnteredStep.resize(total, 0);
+        outOfSyncStep.resize(total, IN_SYNC);
+        measuredX.insert(measuredX.end(), x.begin() + first, x.end());
+        measuredY.insert(measuredY.end(), y.begin() + first, y.end());
+        radioDirty.resize(total, 1);
+        measurementCache.resize(total);
+        pendingX = pendingY = nullptr;
+        pendingOwner.reset();
+    }
+
+    size_t size() const { return requiredSlice.size(); }
+
+    // Replaces the requirements for one slice type, e.g. from a scenario file.
+    // Not thread-safe; call before the simulation starts.
+    void setSliceRequirements(NetworkSlice::SliceType type, const SliceRequirements& requirements) {
+        sliceRequirements[static_cast<size_t>(type)] = requirements;
+    }
+
+    const SliceRequirements& getSliceRequirements(NetworkSlice::SliceType type) const {
+        return sliceRequirements[static_cast<size_t>(type)];
+    }
+
+    // Where per-UE events go; set once by the owner before the simulation starts
+    void setEventLog(EventLog* log) {
+        eventLog = log;
+    }
+
+    // How far a UE may move before its cached measurements are redone;
+    // capped at the shadowing decorrelation distance, past which the cached
+    // shadowing no longer says anything about the UE's new spot.
+    // Not thread-safe; call before the simulation starts.
+    void setMeasurementRefreshDistance(double meters) {
+        refreshDistance = std::clamp(meters, 0.0, SHADOWING_DECORRELATION_DISTANCE);
+    }
+
+    // Bytes of column storage per UE, for capacity planning at large scale;
+    // reported when the population is created.
+    size_t bytesPerUe() const {
+        return elementBytes(x) + elementBytes(y) + elementBytes(speed) + elementBytes(requiredSlice) +
+               elementBytes(requiredBandwidth) + elementBytes(grantedUnits) + elementBytes(currentSignal) +
+               elementBytes(servingStation) + elementBytes(connectionAttempts) + elementBytes(handoverTarget) +
+               elementBytes(handoverEnteredStep) + elementBytes(outOfSyncStep) + elementBytes(measuredX) +
+               elementBytes(measuredY) + elementBytes(radioDirty) + elementBytes(measurementCache);
+    }
+
+    // Direction is drawn from the (UE, step) counter, so any range of UEs may
+    // be moved concurrently and the walk is the same for any thread count.
+    // A UE is marked dirty once it has moved the refresh distance since its
+    // last measurement. Connected UEs whose report could change this step
+    // (dirty, timing an A3 event or out of sync) are appended to due in UE
+    // order; the rest would report exactly what they did last step. Returns
+    // how many connected UEs were left out.
+    size_t move(size_t begin, size_t end, double timeStep, const CounterRng& rng, uint32_t step,
+                std::vector<uint32_t>& due) {
+        const float refresh = static_cast<float>(refreshDistance * refreshDistance);
+        size_t unchanged = 0;
+        for (size_t i = begin; i < end; ++i) {
+            float stride = static_cast<float>(speed[i] * timeStep);
+            x[i] += stride * rng.uniformInt(-1, 1, CounterRng::Stream::Mobility, getId(i), step, 0);
+            y[i] += stride * rng.uniformInt(-1, 1, CounterRng::Stream::Mobility, getId(i), step, 1);
+
+            float measuredDx = x[i] - measuredX[i];
+            float measuredDy = y[i] - measuredY[i];
+            if (measuredDx * measuredDx + measuredDy * measuredDy >= refresh) {
+                radioDirty[i] = 1;
+            }
+            if (!isConnected(i)) continue;
+            if (radioDirty[i] || handoverTarget[i].isValid() || outOfSyncStep[i] != IN_SYNC) {
+                due.push_back(static_cast<uint32_t>(i));
+            } else {
+                unchanged++;
+            }
+        }
+        return unchanged;
+    }
+
+    // Whether UE i has to re-measure before its cache can answer for key
+    bool needsMeasurement(size_t i, uint32_t key) const {
+        uint32_t held = measurementCache[i].member[0];
+        return radioDirty[i] || ((key & SERVING_KEY) ? held != key : (held & SERVING_KEY) != 0);
+    }
+
+    // Shadows and caches a measurement of block positions members[j], whose
+    // median RSRP the SignalKernel put in medianRsrp[j]. Every member counts
+    // towards interference, but only the strongest MeasurementCache::CAPACITY
+    // are kept, in list order; a serving measurement always keeps members[0].
+    // Touches only UE i's state, so different UEs may be refreshed concurrently.
+    void storeMeasurement(size_t i, uint32_t key, const uint32_t* members, size_t memberCount,
+                          const float* medianRsrp, const StationBlock& stations) {
+        thread_local std::vector<float> rsrp;
+        thread_local std::vector<BaseStation::SignalMetrics> metrics;
+        thread_local std::vector<uint32_t> kept;
+        rsrp.resize(memberCount);
+        metrics.resize(memberCount);
+        for (size_t j = 0; j < memberCount; ++j) {
+            rsrp[j] = medianRsrp[j] - stations.shadowingDb(members[j], x[i], y[i]);
+        }
+        stations.deriveSignalMetrics(members, memberCount, rsrp.data(), metrics.data());
+
+        kept.resize(memberCount);
+        std::iota(kept.begin(), kept.end(), 0u);
+        if (memberCount > MeasurementCache::CAPACITY) {
+            auto first = kept.begin() + ((key & SERVING_KEY) ? 1 : 0);
+            std::partial_sort(first, kept.begin() + MeasurementCache::CAPACITY, kept.end(),
+                              [&](uint32_t a, uint32_t b) { return rsrp[a] > rsrp[b] || (rsrp[a] == rsrp[b] && a < b); });
+            kept.resize(MeasurementCache::CAPACITY);
+            std::sort(first, kept.end());
+        }
+
+        MeasurementCache& cache = measurementCache[i];
+        cache = MeasurementCache{};
+        cache.member[0] = NO_MEMBER;
+        for (size_t k = 0; k < kept.size(); ++k) {
+            cache.member[k] = members[kept[k]];
+            cache.rsrp[k] = MeasurementCache::toCentiDb(metrics[kept[k]].rsrp);
+            cache.sinr[k] = MeasurementCache::toCentiDb(metrics[kept[k]].sinr);
+        }
+        cache.member[0] |= key & SERVING_KEY;
+        measuredX[i] = x[i];
+        measuredY[i] = y[i];
+        radioDirty[i] = 0;
+    }
+
+    // Station positions are only valid for the block they were cached
+    // against; call whenever the station grid is rebuilt.
+    void invalidateMeasurements() {
+        for (size_t i = 0; i < measurementCache.size(); ++i) {
+            measurementCache[i] = MeasurementCache{};
+            radioDirty[i] = 1;
+        }
+    }
+
+    // Read-only half of an attach: picks the best station/slice from the
+    // UE's cached measurement against the current resource picture.
+    // Safe to run concurrently for different UEs.
+    CandidateShortlist proposeConnection(size_t i, const StationBlock& stations,
+                                         const SlotMap<NetworkSlice>& slices) const {
+        return evaluatePotentialConnections(i, stations, slices);
+    }
+
+    // Mutating half of an attach. Must run serially; the slice may have been
+    // drained by earlier commits since the proposal was made, so it is re-checked
+    // and the shortlist's runners-up are tried in order.
+    // Backoff is left to the caller, which schedules the retry in simulated time.
+    bool commitConnection(size_t i, const CandidateShortlist& shortlist,
+                          const SlotMap<BaseStation>& stations,
+                          SlotMap<NetworkSlice>& slices) {
+        if (connectionAttempts[i] < std::numeric_limits<uint8_t>::max()) {
+            connectionAttempts[i]++;
+        }
+
+        for (size_t k = 0; k < shortlist.size() && !isConnected(i); ++k) {
+            const NetworkSlice* slice = slices.get(shortlist[k].slice);
+            if (slice && slice->checkAvailableResources() >= requiredBandwidth[i] * 0.5) {
+                establishConnection(i, shortlist[k], stations, slices);
+            }
+        }
+        if (!isConnected(i)) {
+            handleConnectionFailure(i, shortlist.best());
+        }
+
+        return isConnected(i);
+    }
+
+    // Measurement half of a report: serving cell (block position
+    // servingPosition) and its neighbour list, re-measured only when the UE
+    // is dirty or last measured something else. Returns whether it re-measured.
+    // Touches only UE i's state, so different UEs may be measured concurrently.
+    bool measureNeighbours(size_t i, uint32_t servingPosition, const StationBlock& stations) {
+        uint32_t key = servingKey(servingPosition);
+        if (!needsMeasurement(i, key)) return false;
+
+        thread_local std::vector<uint32_t> members;
+        thread_local std::vector<float> rsrp;
+        members.assign(1, servingPosition);
+        members.insert(members.end(), stations.neighbours.begin() + stations.neighbourStart[servingPosition],
+                       stations.neighbours.begin() + stations.neighbourStart[servingPosition + 1]);
+        rsrp.resize(members.size());
+        SignalKernel::measureList(x[i], y[i], stations, members.data(), members.size(), rsrp.data());
+        storeMeasurement(i, key, members.data(), members.size(), rsrp.data(), stations);
+        return true;
+    }
+
+    // Report built from the cached serving and neighbour measurements
+    MeasurementReport reportNeighbours(size_t i, const StationBlock& stations) const {
+        const MeasurementCache& cache = measurementCache[i];
+        MeasurementReport report;
+        const size_t count = cache.count();
+        if (count == 0 || !(cache.member[0] & SERVING_KEY)) return report;
+
+        report.valid = true;
+        report.serving = cache.metrics(0);
+        size_t strongest = 0;
+        for (size_t j = 1; j < count; ++j) {
+            if (!report.neighbourStation.isValid() || cache.rsrp[j] > cache.rsrp[strongest]) {
+                strongest = j;
+                report.neighbour = cache.metrics(j);
+                report.neighbourStation = stations.handle[cache.position(j)];
+                report.neighbourSlice = stations.slice[cache.position(j) * NetworkSlice::TYPE_COUNT +
+                                                       static_cast<size_t>(requiredSlice[i])];
+            }
+        }
+        return report;
+    }
+
+    // What updateLinkState leaves for completeLinkState, as bit flags
+    static constexpr uint8_t HANDOVER_DUE = 1;  // time-to-trigger has elapsed
+    static constexpr uint8_t LINK_EXPIRED = 2;  // T310 has run out
+
+    // outOfSyncStep while T310 is not running
+    static constexpr uint32_t IN_SYNC = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t RETRY_BACKOFF_STEPS =
+            static_cast<uint32_t>(HANDOVER_RETRY_BACKOFF / STEP_DURATION + 0.5);
+
+    // Per-UE half of applying a report, the one of mobility step step:
+    // refreshes the serving SINR and runs the A3 and T310 timers. Reports come
+    // once per step, so the timers are kept as the step they started in.
+    // Touches only UE i's state, so different UEs may be updated
+    // concurrently; returns the flags completeLinkState must act on, or 0
+    // when there is nothing left to do.
+    uint8_t updateLinkState(size_t i, const MeasurementReport& report, uint32_t step,
+                            const HandoverParameters& parameters) {
+        if (!isConnected(i) || !report.valid) return 0;
+        currentSignal[i] = MeasurementCache::toCentiDb(report.serving.sinr);
+
+        if (report.neighbourStation.isValid()) {
+            double servingLevel = report.serving.rsrp + parameters.a3Offset;
+            bool entering = report.neighbour.rsrp - parameters.hysteresis > servingLevel;
+            bool leaving = report.neighbour.rsrp + parameters.hysteresis < servingLevel;
+            if (handoverTarget[i] != report.neighbourStation || leaving) {
+                // A different neighbour restarts the timer, though not before
+                // the backoff a failed handover left behind
+                handoverTarget[i] = entering ? report.neighbourStation : StationHandle{};
+                handoverEnteredStep[i] = std::max(step, handoverEnteredStep[i]);
+            }
+        } else {
+            handoverTarget[i] = StationHandle{};
+        }
+
+        uint8_t pending = 0;
+        if (handoverTarget[i].isValid() &&
+            secondsSince(handoverEnteredStep[i], step) >= parameters.timeToTrigger - 1e-9) {
+            pending |= HANDOVER_DUE;
+        }
+
+        // Out of sync starts T310; the link is only dropped if it stays bad
+        if (report.serving.sinr >= RADIO_LINK_FAILURE_SINR) {
+            outOfSyncStep[i] = IN_SYNC;
+        } else if (outOfSyncStep[i] == IN_SYNC) {
+            outOfSyncStep[i] = step;
+        } else if (secondsSince(outOfSyncStep[i], step) >= RADIO_LINK_FAILURE_TIMER - 1e-9) {
+            pending |= LINK_EXPIRED;
+        }
+        return pending;
+    }
+
+    // Shared half, for UEs updateLinkState flagged: a due handover goes
+    // make-before-break, so the target slice is reserved before the source is
+    // released and a failed reservation leaves the UE where it was. A failed
+    // handover restarts the A3 timer HANDOVER_RETRY_BACKOFF from now, so
+    // time-to-trigger has to be met again after the backoff rather than the
+    // same full target being retried on every report. A UE that did not hand
+    // over and whose T310 ran out is dropped.
+    // Touches slices, so must run serially, in UE order for reproducible
+    // contention.
+    HandoverOutcome completeLinkState(size_t i, uint8_t pending, const MeasurementReport& report, uint32_t step,
+                                      const SlotMap<BaseStation>& stations, SlotMap<NetworkSlice>& slices) {
+        HandoverOutcome outcome = HandoverOutcome::None;
+        if (pending & HANDOVER_DUE) {
+            if (executeHandover(i, report, stations, slices)) {
+                return HandoverOutcome::HandedOver;
+            }
+            handoverEnteredStep[i] = step + RETRY_BACKOFF_STEPS;
+            outcome = HandoverOutcome::Failed;
+        }
+        if (pending & LINK_EXPIRED) {
+            SIM_LOG(Handover, Event) {
+                EventLog::Record failure = event(i, EventLog::Kind::RadioLinkFailure);
+                failure.sinr = report.serving.sinr;
+                log(failure);
+            }
+            disconnect(i, stations, slices);
+            return HandoverOutcome::RadioLinkFailure;
+        }
+        return outcome;
+    }
+
+    bool canRetry(size_t i) const {
+        return !isConnected(i) && connectionAttempts[i] < MAX_CONNECTION_ATTEMPTS;
+    }
+
+    void disconnect(size_t i, const SlotMap<BaseStation>& stations, SlotMap<NetworkSlice>& slices) {
+        if (isConnected(i)) {
+            if (NetworkSlice* slice = slices.get(servingSlice(i, stations))) {
+                slice->releaseResources(grantedUnits[i]);
+            }
+            servingStation[i] = StationHandle{};
+            handoverTarget[i] = StationHandle{};
+            outOfSyncStep[i] = IN_SYNC;
+            SIM_LOG(Attach, Event) log(event(i, EventLog::Kind::Disconnected));
+        }
+    }
+
+    // Getters
+    int getId(size_t i) const { return static_cast<int>(i) + 1; }
+    bool isConnected(size_t i) const { return servingStation[i].isValid(); }
+    double getX(size_t i) const { return x[i]; }
+    double getY(size_t i) const { return y[i]; }
+    int getConnectionAttempts(size_t i) const { return connectionAttempts[i]; }
+    NetworkSlice::SliceType getRequiredSlice(size_t i) const { return requiredSlice[i]; }
+    StationHandle getServingStation(size_t i) const { return servingStation[i]; }
+    float getCurrentSignal(size_t i) const { return currentSignal[i] / 100.0f; }
+    double getRequiredBandwidth(size_t i) const { return requiredBandwidth[i]; }
+    double getAllocatedBandwidth(size_t i) const { return NetworkSlice::toMHz(grantedUnits[i]); }
+
+    // Slice weight used to rank competing attach requests
+    double getAdmissionWeight(size_t i) const {
+        return getSliceRequirements(requiredSlice[i]).bandwidthPriority;
+    }
+
+private:
+    // Shadowed RSRP/SINR of the block positions a UE last measured, inline
+    // in the column so a UE's cache is one fixed-size record. As many
+    // members are kept as an attach shortlist holds, which for a report is
+    // the serving cell and its two strongest neighbours. Levels are kept to
+    // 0.01 dB, and the first member carries the key: SERVING_KEY set for a
+    // report, clear for an attach. Unused members hold NO_MEMBER.
+    struct MeasurementCache {
+        static constexpr size_t CAPACITY = CandidateShortlist::CAPACITY;
+
+        std::array<uint32_t, CAPACITY> member = {NO_MEASUREMENT, NO_MEMBER, NO_MEMBER};
+        std::array<int16_t, CAPACITY> rsrp{};  // centi-dB
+        std::array<int16_t, CAPACITY> sinr{};  // centi-dB
+
+        static int16_t toCentiDb(double db) {
+            return static_cast<int16_t>(std::lround(std::clamp(db * 100, -32768.0, 32767.0)));
+        }
+
+        size_t count() const {
+            size_t n = 0;
+            while (n < CAPACITY && position(n) != NO_MEMBER) n++;
+            return n;
+        }
+        uint32_t position(size_t j) const { return member[j] & ~SERVING_KEY; }
+        BaseStation::SignalMetrics metrics(size_t j) const { return {sinr[j] / 100.0, rsrp[j] / 100.0}; }
+    };
+
+    // One table shared by the whole population rather than a copy per UE
+    SliceRequirementTable sliceRequirements = DEFAULT_SLICE_REQUIREMENTS;
+    double refreshDistance = MEASUREMENT_REFRESH_DISTANCE;
+    EventLog* eventLog = nullptr;
+
+    CandidateShortlist evaluatePotentialConnections(size_t i, const StationBlock& stations,
+                                                    const SlotMap<NetworkSlice>& slices) const {
+        CandidateShortlist shortlist;
+        const SliceRequirements& requirements = getSliceRequirements(requiredSlice[i]);
+        const MeasurementCache& cache = measurementCache[i];
+
+        for (size_t j = 0, count = cache.count(); j < count; ++j) {
+            const BaseStation::SignalMetrics metrics = cache.metrics(j);
+
+            if (metrics.sinr < requirements.minSinr || metrics.rsrp < requirements.minRsrp) {
+                continue;
+            }
+
+            // Capacity of the required slice on this particular gNB
+            SliceHandle sliceHandle = stations.slice[cache.position(j) * NetworkSlice::TYPE_COUNT +
+                                                     static_cast<size_t>(requiredSlice[i])];
+            const NetworkSlice* slice = slices.get(sliceHandle);
+            if (!slice) continue;
+
+            double availableBW = slice->checkAvailableResources();
+            if (availableBW >= requiredBandwidth[i] * 0.5) {
+                shortlist.offer(ConnectionCandidate{stations.handle[cache.position(j)], sliceHandle,
+                                                    metrics.sinr, metrics.rsrp, availableBW});
+            }
+        }
+
+        return shortlist;
+    }
+
+    void establishConnection(size_t i, const ConnectionCandidate& candidate,
+                             const SlotMap<BaseStation>& stations,
+                             SlotMap<NetworkSlice>& slices) {
+        NetworkSlice& slice = *slices.get(candidate.slice);
+        int64_t granted = slice.allocateResources(requiredBandwidth[i]);
+        if (granted > 0) {
+            servingStation[i] = candidate.station;
+            currentSignal[i] = MeasurementCache::toCentiDb(candidate.sinr);
+            grantedUnits[i] = static_cast<uint32_t>(granted);
+            connectionAttempts[i] = 0;
+            radioDirty[i] = 1;  // the cache holds the attach measurement, not the serving one
+
+            SIM_LOG(Attach, Event) {
+                EventLog::Record connection = event(i, EventLog::Kind::Connected);
+                connection.station = stations.get(candidate.station)->getId();
+                connection.sinr = candidate.sinr;
+                connection.rsrp = candidate.rsrp;
+                connection.allocated = NetworkSlice::toMHz(granted);
+                log(connection);
+            }
+        } else {
+            SIM_LOG(Attach, Event) log(event(i, EventLog::Kind::AllocationFailed));
+        }
+    }
+
+    bool executeHandover(size_t i, const MeasurementReport& report,
+                         const SlotMap<BaseStation>& stations, SlotMap<NetworkSlice>& slices) {
+        const SliceRequirements& requirements = getSliceRequirements(requiredSlice[i]);
+        NetworkSlice* target = slices.get(report.neighbourSlice);
+        const BaseStation* from = stations.get(servingStation[i]);
+        const BaseStation* to = stations.get(report.neighbourStation);
+        if (!target || !from || !to || report.neighbour.sinr < requirements.minSinr ||
+            report.neighbour.rsrp < requirements.minRsrp) {
+            return false;
+        }
+
+        int64_t granted = target->allocateResources(requiredBandwidth[i]);
+        if (NetworkSlice::toMHz(granted) < requiredBandwidth[i] * 0.5) {
+            target->releaseResources(granted);
+            SIM_LOG(Handover, Event) {
+                EventLog::Record failure = event(i, EventLog::Kind::HandoverFailed);
+                failure.target = to->getId();
+                log(failure);
+            }
+            return false;
+        }
+        if (NetworkSlice* source = slices.get(from->getSlice(requiredSlice[i]))) {
+            source->releaseResources(grantedUnits[i]);
+        }
+
+        SIM_LOG(Handover, Event) {
+            EventLog::Record handover = event(i, EventLog::Kind::HandedOver);
+            handover.station = from->getId();
+            handover.target = to->getId();
+            handover.rsrp = report.serving.rsrp;
+            handover.value = report.neighbour.rsrp;
+            log(handover);
+        }
+        servingStation[i] = report.neighbourStation;
+        grantedUnits[i] = static_cast<uint32_t>(granted);
+        currentSignal[i] = MeasurementCache::toCentiDb(report.neighbour.sinr);
+        handoverTarget[i] = StationHandle{};
+        outOfSyncStep[i] = IN_SYNC;
+        radioDirty[i] = 1;
+        return true;
+    }
+
+    void handleConnectionFailure(size_t i, const ConnectionCandidate& bestCandidate) {
+        SIM_LOG(Attach, Event) {
+            if (bestCandidate.station.isValid()) {
+                EventLog::Record rejection = event(i, EventLog::Kind::CandidateRejected);
+                rejection.sinr = bestCandidate.sinr;
+                rejection.rsrp = bestCandidate.rsrp;
+                rejection.value = bestCandidate.availableBandwidth;
+                log(rejection);
+            } else {
+                EventLog::Record rejection = event(i, EventLog::Kind::NoViableStation);
+                rejection.attempt = connectionAttempts[i];
+                log(rejection);
+            }
+        }
+    }
+
+    // A record for UE i with its slice and demand filled in
+    EventLog::Record event(size_t i, EventLog::Kind kind) const {
+        EventLog::Record record;
+        record.kind = kind;
+        record.ue = static_cast<uint32_t>(getId(i));
+        record.slice = requiredSlice[i];
+        record.required = requiredBandwidth[i];
+        return record;
+    }
+
+    void log(const EventLog::Record& record) {
+        if (eventLog) {
+            eventLog->record(record);
+        } else {
+            EventLog::render(std::cout, record);
+        }
+    }
+
+    // Seconds from the report of step since to that of step now
+    static double secondsSince(uint32_t since, uint32_t now) {
+        return (static_cast<double>(now) - since) * STEP_DURATION;
+    }
+
+    // The pool a connected UE holds its grant in: its slice type on the serving cell
+    SliceHandle servingSlice(size_t i, const SlotMap<BaseStation>& stations) const {
+        const BaseStation* station = stations.get(servingStation[i]);
+        return station ? station->getSlice(requiredSlice[i]) : SliceHandle{};
+    }
+
+    template <typename Column>
+    static constexpr size_t elementBytes(const Column&) { return sizeof(typename Column::value_type); }
+
+    // Positions are float, as the signal kernel evaluates them; a UE is
+    // connected while it has a serving station
+    std::vector<float> x, y;
+    ReadOnlyColumn<float> speed;
+    ReadOnlyColumn<NetworkSlice::SliceType> requiredSlice;
+    ReadOnlyColumn<float> requiredBandwidth;
+    std::vector<uint32_t> grantedUnits;          // NetworkSlice units (kHz) held on the serving slice; demands are at most 1e6 MHz
+    std::vector<int16_t> currentSignal;          // serving SINR, centi-dB
+    std::vector<StationHandle> servingStation;
+    std::vector<uint8_t> connectionAttempts;
+    std::vector<StationHandle> handoverTarget;  // neighbour the A3 timer runs for
+    std::vector<uint32_t> handoverEnteredStep;  // step the A3 event was entered, or the end of a retry backoff
+    std::vector<uint32_t> outOfSyncStep;        // step T310 started, or IN_SYNC
+    std::vector<float> measuredX, measuredY;    // position of the last measurement
+    std::vector<uint8_t> radioDirty;            // moved far enough that cached measurements are stale
+    std::vector<MeasurementCache> measurementCache;
+
+    // Start positions of the UEs addColumns() left for materialize()
+    const double* pendingX = nullptr;
+    const double* pendingY = nullptr;
+    std::shared_ptr<const void> pendingOwner;
+};
+
+// Hot loops of the MAC scheduler, vectorized over the UEs of a cell. Uses
+// the instruction set chosen for SignalKernel, so --simd caps both.
+class SchedulerKernel {
+public:
+    // owner[p] = argmax over u of rate[p * ueCount + u] * weight[u], lowest u
+    // on ties. Products are plain multiplies, so every path picks the same UE.
+    static void argmaxPerPrb(const float* rate, const float* weight, size_t ueCount, size_t prbCount,
+                             uint32_t* owner) {
+        switch (SignalKernel::isa()) {
+#if SIGNAL_KERNEL_X86
+            case SignalKernel::Isa::Avx512: argmaxPerPrbAvx512(rate, weight, ueCount, prbCount, owner); return;
+            case SignalKernel::Isa::Avx2: argmaxPerPrbAvx2(rate, weight, ueCount, prbCount, owner); return;
+#endif
+            default: argmaxPerPrbScalar(rate, weight, ueCount, prbCount, owner); return;
+        }
+    }
+
+    // One EWMA step over a whole cell: average += (slotBits - average) * alpha,
+    // floored at minAverage; weight = 1 / average for the next PF slot, and
+    // slotBits is added into totalBits.
+    static void updateAverages(float* average, float* weight, const float* slotBits, float* totalBits,
+                               size_t count, float alpha, float minAverage) {
+        switch (SignalKernel::isa()) {
+#if SIGNAL_KERNEL_X86
+            case SignalKernel::Isa::Avx512:
+                updateAveragesAvx512(average, weight, slotBits, totalBits, count, alpha, minAverage);
+                return;
+            case SignalKernel::Isa::Avx2:
+                updateAveragesAvx2(average, weight, slotBits, totalBits, count, alpha, minAverage);
+                return;
+#endif
+            default:
+                updateAveragesScalar(average, weight, slotBits, totalBits, count, alpha, minAverage, 0);
+                return;
+        }
+    }
+
+private:
+    // Continues a row from u = first with the running best so far
+    static uint32_t argmaxRowScalar(const float* row, const float* weight, size_t first, size_t count,
+                                    float bestMetric, uint32_t best) {
+        for (size_t u = first; u < count; ++u) {
+            float metric = row[u] * weight[u];
+            if (metric > bestMetric) {
+                bestMetric = metric;
+                best = static_cast<uint32_t>(u);
+            }
+        }
+        return best;
+    }
+
+    static void argmaxPerPrbScalar(const float* rate, const float* weight, size_t ueCount, size_t prbCount,
+                                   uint32_t* owner) {
+        for (size_t p = 0; p < prbCount; ++p) {
+            owner[p] = argmaxRowScalar(rate + p * ueCount, weight, 0, ueCount, -1.0f, 0);
+        }
+    }
+
+    // Largest lane value, lowest index among equal values
+    template <size_t W>
+    static std::pair<float, uint32_t> reduceLanes(const std::array<float, W>& value,
+                                                  const std::array<uint32_t, W>& index) {
+        size_t winner = 0;
+        for (size_t lane = 1; lane < W; ++lane) {
+            if (value[lane] > value[winner] ||
+                (value[lane] == value[winner] && index[lane] < index[winner])) {
+                winner = lane;
+            }
+        }
+        return {value[winner], index[winner]};
+    }
+
+    static void updateAveragesScalar(float* average, float* weight, const float* slotBits, float* totalBits,
+                                     size_t count, float alpha, float minAverage, size_t first) {
+        for (size_t u = first; u < count; ++u) {
+            float updated = average[u] + (slotBits[u] - average[u]) * alpha;
+            average[u] = std::max(updated, minAverage);
+            weight[u] = 1.0f / average[u];
+            totalBits[u] += slotBits[u];
+        }
+    }
+
+#if SIGNAL_KERNEL_X86
+    __attribute__((target("avx2")))
+    static void argmaxPerPrbAvx2(const float* rate, const float* weight, size_t ueCount, size_t prbCount,
+                                 uint32_t* owner) {
+        constexpr size_t W = 8;
+        const size_t vectorEnd = ueCount / W * W;
+        if (vectorEnd == 0) {
+            argmaxPerPrbScalar(rate, weight, ueCount, prbCount, owner);
+            return;
+        }
+        for (size_t p = 0; p < prbCount; ++p) {
+            const float* row = rate + p * ueCount;
+            __m256 bestMetric = _mm256_set1_ps(-1.0f);
+            __m256i best = _mm256_setzero_si256();
+            __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            for (size_t u = 0; u < vectorEnd; u += W) {
+                __m256 metric = _mm256_mul_ps(_mm256_loadu_ps(row + u), _mm256_loadu_ps(weight + u));
+                __m256 better = _mm256_cmp_ps(metric, bestMetric, _CMP_GT_OQ);
+                bestMetric = _mm256_blendv_ps(bestMetric, metric, better);
+                best = _mm256_blendv_epi8(best, index, _mm256_castps_si256(better));
+                index = _mm256_add_epi32(index, _mm256_set1_epi32(W));
+            }
+            std::array<float, W> laneMetric;
+            std::array<uint32_t, W> laneBest;
+            _mm256_storeu_ps(laneMetric.data(), bestMetric);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneBest.data()), best);
+            auto [metric, winner] = reduceLanes(laneMetric, laneBest);
+            owner[p] = argmaxRowScalar(row, weight, vectorEnd, ueCount, metric, winner);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    static void updateAveragesAvx2(float* average, float* weight, const float* slotBits, float* totalBits,
+                                   size_t count, float alpha, float minAverage) {
+        constexpr size_t W = 8;
+        const size_t vectorEnd = count / W * W;
+        const __m256 a = _mm256_set1_ps(alpha);
+        const __m256 floor = _mm256_set1_ps(minAverage);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        for (size_t u = 0; u < vectorEnd; u += W) {
+            __m256 bits = _mm256_loadu_ps(slotBits + u);
+            __m256 avg = _mm256_loadu_ps(average + u);
+            avg = _mm256_add_ps(avg, _mm256_mul_ps(_mm256_sub_ps(bits, avg), a));
+            avg = _mm256_max_ps(avg, floor);
+            _mm256_storeu_ps(average + u, avg);
+            _mm256_storeu_ps(weight + u, _mm256_div_ps(one, avg));
+            _mm256_storeu_ps(totalBits + u, _mm256_add_ps(_mm256_loadu_ps(totalBits + u), bits));
+        }
+        updateAveragesScalar(average, weight, slotBits, totalBits, count, alpha, minAverage, vectorEnd);
+    }
+
+    __attribute__((target("avx512f")))
+    static void argmaxPerPrbAvx512(const float* rate, const float* weight, size_t ueCount, size_t prbCount,
+                                   uint32_t* owner) {
+        constexpr size_t W = 16;
+        const size_t vectorEnd = ueCount / W * W;
+        if (vectorEnd == 0) {
+            argmaxPerPrbAvx2(rate, weight, ueCount, prbCount, owner);
+            return;
+        }
+        for (size_t p = 0; p < prbCount; ++p) {
+            const float* row = rate + p * ueCount;
+            __m512 bestMetric = _mm512_set1_ps(-1.0f);
+            __m512i best = _mm512_setzero_si512();
+            __m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+            for (size_t u = 0; u < vectorEnd; u += W) {
+                __m512 metric = _mm512_mul_ps(_mm512_loadu_ps(row + u), _mm512_loadu_ps(weight + u));
+                __mmask16 better = _mm512_cmp_ps_mask(metric, bestMetric, _CMP_GT_OQ);
+                bestMetric = _mm512_mask_mov_ps(bestMetric, better, metric);
+                best = _mm512_mask_mov_epi32(best, better, index);
+                index = _mm512_add_epi32(index, _mm512_set1_epi32(W));
+            }
+            std::array<float, W> laneMetric;
+            std::array<uint32_t, W> laneBest;
+            _mm512_storeu_ps(laneMetric.data(), bestMetric);
+            _mm512_storeu_si512(laneBest.data(), best);
+            auto [metric, winner] = reduceLanes(laneMetric, laneBest);
+            owner[p] = argmaxRowScalar(row, weight, vectorEnd, ueCount, metric, winner);
+        }
+    }
+
+    // avx512f lets the compiler fuse the update into an FMA, so averages may
+    // differ from the narrower paths in the last bit.
+    __attribute__((target("avx512f")))
+    static void updateAveragesAvx512(float* average, float* weight, const float* slotBits, float* totalBits,
+                                     size_t count, float alpha, float minAverage) {
+        constexpr size_t W = 16;
+        const size_t vectorEnd = count / W * W;
+        const __m512 a = _mm512_set1_ps(alpha);
+        const __m512 floor = _mm512_set1_ps(minAverage);
+        const __m512 one = _mm512_set1_ps(1.0f);
+        for (size_t u = 0; u < vectorEnd; u += W) {
+            __m512 bits = _mm512_loadu_ps(slotBits + u);
+            __m512 avg = _mm512_loadu_ps(average + u);
+            avg = _mm512_add_ps(avg, _mm512_mul_ps(_mm512_sub_ps(bits, avg), a));
+            avg = _mm512_max_ps(avg, floor);
+            _mm512_storeu_ps(average + u, avg);
+            _mm512_storeu_ps(weight + u, _mm512_div_ps(one, avg));
+            _mm512_storeu_ps(totalBits + u, _mm512_add_ps(_mm512_loadu_ps(totalBits + u), bits));
+        }
+        updateAveragesScalar(average, weight, slotBits, totalBits, count, alpha, minAverage, vectorEnd);
+    }
+#endif
+};
+
+// Per-gNB MAC scheduler. Every slot (TTI) each PRB of a cell is granted to
+// one of the cell's connected UEs, all of which have full buffers. The channel
+// is frequency selective: every UE sees a 4-tap Rayleigh profile, redrawn
+// each coherence block, on top of its wideband SINR. Per-PRB rates are
+// tabulated PRB-major once per block, so a slot is one pass over the table.
+// PF averages are gathered into a contiguous cell column for the run and
+// updated for all of the cell's UEs at once each slot.
+class MacScheduler {
+public:
+    enum class Policy : uint8_t {
+        RoundRobin, ProportionalFair, MaxCI
+    };
+
+    static constexpr double SLOT_DURATION = 0.5e-3;         // NR slot at 30 kHz subcarrier spacing
+    static constexpr uint32_t COHERENCE_SLOTS = 20;          // fading is redrawn every 10 ms
+    static constexpr size_t MAX_PRB_COUNT = 275;             // largest NR carrier
+    static constexpr double PRB_BANDWIDTH = 12 * 30e3;       // Hz
+    static constexpr float RESOURCE_ELEMENTS_PER_PRB = 12 * 14 * (1 - 0.14f);  // per slot, less control overhead
+    static constexpr float PF_TIME_CONSTANT = 100;           // averaging window in slots
+    static constexpr float MIN_AVERAGE_RATE = 1e-3f;         // bits per slot; keeps PF weights finite
+
+    explicit MacScheduler(Policy policy = Policy::ProportionalFair) : policy(policy) {}
+
+    void setPolicy(Policy value) { policy = value; }
+    Policy getPolicy() const { return policy; }
+
+    std::string getPolicyName() const {
+        switch (policy) {
+            case Policy::RoundRobin: return "RR";
+            case Policy::ProportionalFair: return "PF";
+            case Policy::MaxCI: return "max-C/I";
+            default: return "Unknown";
+        }
+    }
+
+    // Per-UE state follows UE store indices, per-cell state dense station indices
+    void resize(size_t ueCount, size_t cellCount) {
+        averageRate.resize(ueCount, 1.0f);
+        deliveredBits.resize(ueCount, 0);
+        nextPrbOwner.resize(cellCount, 0);
+    }
+
+    // Mirrors the station slot map's swap-remove of dense index cell
+    void removeCell(size_t cell) {
+        if (cell >= nextPrbOwner.size()) return;
+        nextPrbOwner[cell] = nextPrbOwner.back();
+        nextPrbOwner.pop_back();
+    }
+
+    // Runs slots [firstSlot, firstSlot + slotCount) of one cell. ues lists the
+    // cell's connected UEs by store index and sinrDb their wideband SINR.
+    // Cells share no state, so different cells may be scheduled concurrently.
+    // Returns the bits delivered in the cell.
+    double runCell(size_t cell, const uint32_t* ues, const float* sinrDb, size_t ueCount, size_t prbCount,
+                   uint64_t firstSlot, uint32_t slotCount, const CounterRng& rng) {
+        if (ueCount == 0) return 0;
+        prbCount = std::min(prbCount, MAX_PRB_COUNT);
+
+        CellColumns& columns = cellColumns();
+        columns.rate.resize(prbCount * ueCount);
+        columns.slotBits.resize(ueCount);
+        columns.totalBits.assign(ueCount, 0.0f);
+        columns.average.resize(ueCount);
+        columns.weight.resize(ueCount);
+        columns.unitWeight.assign(ueCount, 1.0f);
+        columns.owner.resize(prbCount);
+        for (size_t u = 0; u < ueCount; ++u) {
+            columns.average[u] = averageRate[ues[u]];
+            columns.weight[u] = 1.0f / columns.average[u];
+        }
+
+        const uint64_t endSlot = firstSlot + slotCount;
+        for (uint64_t slot = firstSlot; slot < endSlot;) {
+            uint64_t block = slot / COHERENCE_SLOTS;
+            uint64_t blockEnd = std::min(endSlot, (block + 1) * COHERENCE_SLOTS);
+            tabulateRates(ues, sinrDb, ueCount, prbCount, static_cast<uint32_t>(block), rng, columns.rate.data());
+            for (; slot < blockEnd; ++slot) {
+                scheduleSlot(cell, ueCount, prbCount, columns);
+            }
+        }
+
+        double total = 0;
+        for (size_t u = 0; u < ueCount; ++u) {
+            averageRate[ues[u]] = columns.average[u];
+            deliveredBits[ues[u]] = columns.totalBits[u];
+            total += columns.totalBits[u];
+        }
+        return total;
+    }
+
+    // Bits UE i received in the last run of its cell
+    double getDeliveredBits(size_t i) const { return deliveredBits[i]; }
+
+private:
+    static constexpr size_t TAP_COUNT = 4;
+
+    // Rotation of tap k at the centre of PRB p, e^{-j 2 pi f_p tau_k}; the same
+    // for every UE, so it is computed once.
+    struct TapRotations {
+        std::array<float, MAX_PRB_COUNT * TAP_COUNT> re, im;
+    };
+
+    static const TapRotations& tapRotations() {
+        static const TapRotations table = [] {
+            constexpr std::array<double, TAP_COUNT> delay = {0, 150e-9, 400e-9, 900e-9};  // s
+            TapRotations rotations;
+            for (size_t p = 0; p < MAX_PRB_COUNT; ++p) {
+                for (size_t k = 0; k < TAP_COUNT; ++k) {
+                    double phase = -2.0 * std::numbers::pi * (p + 0.5) * PRB_BANDWIDTH * delay[k];
+                    rotations.re[p * TAP_COUNT + k] = static_cast<float>(std::cos(phase));
+                    rotations.im[p * TAP_COUNT + k] = static_cast<float>(std::sin(phase));
+                }
+            }
+            return rotations;
+        }();
+        return table;
+    }
+
+    static float bitsPerPrb(float sinrDb) {
+        return RESOURCE_ELEMENTS_PER_PRB * LinkAbstraction::spectralEfficiency(sinrDb);
+    }
+
+    // Exponent plus a cubic fit of log2 over the mantissa in [1, 2), within
+    // 1.3e-3 of std::log2; libm's log10f dominated rate tabulation.
+    static float fastLog2(float x) {
+        uint32_t bits = std::bit_cast<uint32_t>(x);
+        float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+        float m = std::bit_cast<float>((bits & 0x007FFFFFu) | 0x3F800000u);
+        return exponent + ((0.15392465f * m - 1.02955839f) * m + 3.01085099f) * m - 2.13388663f;
+    }
+
+    // Tap gains are keyed by (UE, coherence block, tap), so a UE's channel
+    // does not depend on which cell or thread schedules it. They are drawn
+    // into per-tap columns first so each PRB row is then written in one
+    // contiguous sweep over the UEs.
+    void tabulateRates(const uint32_t* ues, const float* sinrDb, size_t ueCount, size_t prbCount,
+                       uint32_t block, const CounterRng& rng, float* rate) const {
+        constexpr std::array<double, TAP_COUNT> tapPower = {0.5, 0.25, 0.15, 0.1};  // sums to 1
+        const TapRotations& rotations = tapRotations();
+
+        constexpr float DB_PER_OCTAVE = 3.0103f;  // 10 log10(2)
+
+        thread_local std::vector<float> tapReColumns, tapImColumns;
+        tapReColumns.resize(TAP_COUNT * ueCount);
+        tapImColumns.resize(TAP_COUNT * ueCount);
+        float* tapRe = tapReColumns.data();  // tapRe[k * ueCount + u]
+        float* tapIm = tapImColumns.data();
+        for (size_t u = 0; u < ueCount; ++u) {
+            for (size_t k = 0; k < TAP_COUNT; ++k) {
+                auto n = rng.normalPair(CounterRng::Stream::Fading, ues[u], block, static_cast<uint32_t>(k));
+                double scale = std::sqrt(tapPower[k] / 2);
+                tapRe[k * ueCount + u] = static_cast<float>(n[0] * scale);
+                tapIm[k * ueCount + u] = static_cast<float>(n[1] * scale);
+            }
+        }
+
+        for (size_t p = 0; p < prbCount; ++p) {
+            float* row = rate + p * ueCount;
+            for (size_t u = 0; u < ueCount; ++u) {
+                float hRe = 0, hIm = 0;
+                for (size_t k = 0; k < TAP_COUNT; ++k) {
+                    float cosine = rotations.re[p * TAP_COUNT + k];
+                    float sine = rotations.im[p * TAP_COUNT + k];
+                    hRe += tapRe[k * ueCount + u] * cosine - tapIm[k * ueCount + u] * sine;
+                    hIm += tapRe[k * ueCount + u] * sine + tapIm[k * ueCount + u] * cosine;
+                }
+                float fadingDb = DB_PER_OCTAVE * fastLog2(hRe * hRe + hIm * hIm);
+                row[u] = bitsPerPrb(sinrDb[u] + fadingDb);
+            }
+        }
+    }
+
+    // Scratch for one cell's run, indexed by position in the cell's UE list;
+    // one set per thread, reused across cells and steps.
+    struct CellColumns {
+        std::vector<float> rate;       // rate[prb * ueCount + u], bits per PRB per slot
+        std::vector<float> slotBits;   // granted in the current slot
+        std::vector<float> totalBits;  // granted over the whole run
+        std::vector<float> average;    // PF average, bits per slot
+        std::vector<float> weight;     // PF metric weight, 1 / average
+        std::vector<float> unitWeight; // max-C/I metric weight, all ones
+        std::vector<uint32_t> owner;   // UE granted each PRB in the current slot
+    };
+
+    static CellColumns& cellColumns() {
+        thread_local CellColumns columns;
+        return columns;
+    }
+
+    // Grants every PRB of one slot and updates the PF averages. Ties go to
+    // the UE listed first, so results are reproducible.
+    void scheduleSlot(size_t cell, size_t ueCount, size_t prbCount, CellColumns& columns) {
+        const float* rate = columns.rate.data();
+        float* slotBits = columns.slotBits.data();
+        std::fill(slotBits, slotBits + ueCount, 0.0f);
+
+        switch (policy) {
+            case Policy::RoundRobin: {
+                // PRB-level rotation that carries over from slot to slot
+                uint32_t owner = nextPrbOwner[cell] % ueCount;
+                for (size_t p = 0; p < prbCount; ++p) {
+                    slotBits[owner] += rate[p * ueCount + owner];
+                    if (++owner == ueCount) owner = 0;
+                }
+                nextPrbOwner[cell] = owner;
+                break;
+            }
+
+            case Policy::MaxCI:
+            case Policy::ProportionalFair:
+                // max-C/I is PF with every UE weighted alike
+                SchedulerKernel::argmaxPerPrb(rate, policy == Policy::MaxCI ? columns.unitWeight.data()
+                                                                            : columns.weight.data(),
+                                              ueCount, prbCount, columns.owner.data());
+                for (size_t p = 0; p < prbCount; ++p) {
+                    uint32_t owner = columns.owner[p];
+                    slotBits[owner] += rate[p * ueCount + owner];
+                }
+                break;
+        }
+
+        SchedulerKernel::updateAverages(columns.average.data(), columns.weight.data(), slotBits, columns.totalBits.data(),
+                                        ueCount, 1.0f / PF_TIME_CONSTANT, MIN_AVERAGE_RATE);
+    }
+
+    Policy policy;
+    std::vector<float> averageRate;      // EWMA of bits per slot, per UE
+    std::vector<double> deliveredBits;   // per UE
+    std::vector<uint32_t> nextPrbOwner;  // round robin position, per cell
+};
+
+class ThreadPool {
+public:
+    // The calling thread takes part in every parallelFor, so threadCount - 1
+    // workers are spawned.
+    explicit ThreadPool(size_t threadCount) {
+        for (size_t i = 1; i < threadCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    // Runs fn(begin, end) over chunks of [0, count) and blocks until all chunks
+    // are done. Batches smaller than minParallel run inline on the caller.
+    void parallelFor(size_t count, size_t minParallel,
+                     const std::function<void(size_t, size_t)>& fn) {
+        if (workers.empty() || count < minParallel) {
+            fn(0, count);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            chunkSize = std::max<size_t>(1, count / (size() * 8));
+            nextChunk = 0;
+            activeWorkers = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        runChunks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return activeWorkers == 0; });
+        job = nullptr;
+    }
+
+    // parallelFor for passes that produce a list: fn(begin, end, part)
+    // appends to a part of its own, and the parts are joined into out in
+    // range order, so out is the same for any thread count. Returns the sum
+    // of fn's return values.
+    template <typename T, typename Fn>
+    size_t parallelCollect(size_t count, size_t minParallel, std::vector<T>& out, Fn&& fn) {
+        out.clear();
+        if (workers.empty() || count < minParallel) {
+            return fn(size_t{0}, count, out);
+        }
+
+        const size_t partSize = std::max<size_t>(1, count / (size() * 8));
+        std::vector<std::vector<T>> parts((count + partSize - 1) / partSize);
+        std::atomic<size_t> total{0};
+        parallelFor(parts.size(), 1, [&](size_t first, size_t last) {
+            size_t sum = 0;
+            for (size_t p = first; p < last; ++p) {
+                sum += fn(p * partSize, std::min((p + 1) * partSize, count), parts[p]);
+            }
+            total += sum;
+        });
+        for (const std::vector<T>& part : parts) {
+            out.insert(out.end(), part.begin(), part.end());
+        }
+        return total;
+    }
+
+private:
+    void workerLoop() {
+        size_t seenGeneration = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seenGeneration; });
+                if (stopping) return;
+                seenGeneration = generation;
+            }
+
+            runChunks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--activeWorkers == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    void runChunks() {
+        while (true) {
+            size_t begin = nextChunk.fetch_add(chunkSize);
+            if (begin >= jobCount) return;
+            (*job)(begin, std::min(begin + chunkSize, jobCount));
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    size_t chunkSize = 1;
+    std::atomic<size_t> nextChunk{0};
+    size_t activeWorkers = 0;
+    size_t generation = 0;
+    bool stopping = false;
+};
+
+class EventQueue {
+public:
+    enum class EventType {
+        StepBegin, SiteChange, Move, Measure, ConnectAttempt, MacSchedule, StatusReport
+    };
+
+    static constexpr int ALL_UES = -1;
+
+    // Event times are snapped to whole ticks, so sums of backoff intervals
+    // land exactly on step boundaries and events due at the same instant
+    // compare equal.
+    static int64_t toTicks(double seconds) { return std::llround(seconds * TICKS_PER_SECOND); }
+    static double toSeconds(int64_t ticks) { return static_cast<double>(ticks) / TICKS_PER_SECOND; }
+
+    struct Event {
+        double time;  // toSeconds(tick)
+        int64_t tick;
+        EventType type;
+        int ueIndex;  // for SiteChange, the index into the scenario's siteEvents
+        uint64_t sequence;
+    };
+
+    void schedule(double time, EventType type, int ueIndex = ALL_UES) {
+        int64_t tick = toTicks(time);
+        queue.push(Event{toSeconds(tick), tick, type, ueIndex, nextSequence++});
+    }
+
+    Event pop() {
+        Event event = queue.top();
+        queue.pop();
+        currentTime = event.time;
+        return event;
+    }
+
+    const Event& peek() const { return queue.top(); }
+    bool empty() const { return queue.empty(); }
+    double now() const { return currentTime; }
+
+private:
+    // Earliest time first; events scheduled for the same instant keep their
+    // scheduling order so runs are deterministic.
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            if (a.tick != b.tick) return a.tick > b.tick;
+            return a.sequence > b.sequence;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, Later> queue;
+    double currentTime = 0;
+    uint64_t nextSequence = 0;
+};
+
+// Successive-shortest-path min-cost flow. Paths are found with a queue-based
+// Bellman-Ford, so negative edge costs are fine as long as the graph has no
+// negative cycle. Meant for small graphs; admission uses it only to validate.
+class MinCostFlow {
+public:
+    explicit MinCostFlow(size_t nodeCount) : adjacency(nodeCount) {}
+
+    void addEdge(size_t from, size_t to, int64_t capacity, double cost) {
+        adjacency[from].push_back(Edge{to, adjacency[to].size(), capacity, cost});
+        adjacency[to].push_back(Edge{from, adjacency[from].size() - 1, 0, -cost});
+    }
+
+    // Augments from source to sink while the cheapest path still has negative
+    // cost, i.e. finds the minimum-cost flow of any value. Returns its cost.
+    double solve(size_t source, size_t sink) {
+        constexpr double EPSILON = 1e-12;
+        const size_t nodeCount = adjacency.size();
+        double totalCost = 0;
+        std::vector<double> distance(nodeCount);
+        std::vector<std::pair<size_t, size_t>> parent(nodeCount);  // (node, edge index)
+        std::vector<bool> queued(nodeCount);
+        std::queue<size_t> frontier;
+
+        while (true) {
+            std::fill(distance.begin(), distance.end(), std::numeric_limits<double>::infinity());
+            distance[source] = 0;
+            frontier.push(source);
+            queued[source] = true;
+            while (!frontier.empty()) {
+                size_t node = frontier.front();
+                frontier.pop();
+                queued[node] = false;
+                for (size_t e = 0; e < adjacency[node].size(); ++e) {
+                    const Edge& edge = adjacency[node][e];
+                    if (edge.capacity > 0 && distance[node] + edge.cost < distance[edge.to] - EPSILON) {
+                        distance[edge.to] = distance[node] + edge.cost;
+                        parent[edge.to] = {node, e};
+                        if (!queued[edge.to]) {
+                            frontier.push(edge.to);
+                            queued[edge.to] = true;
+                        }
+                    }
+                }
+            }
+            if (distance[sink] >= -EPSILON) return totalCost;
+
+            int64_t push = std::numeric_limits<int64_t>::max();
+            for (size_t node = sink; node != source; node = parent[node].first) {
+                push = std::min(push, adjacency[parent[node].first][parent[node].second].capacity);
+            }
+            for (size_t node = sink; node != source; node = parent[node].first) {
+                Edge& edge = adjacency[parent[node].first][parent[node].second];
+                edge.capacity -= push;
+                adjacency[node][edge.reverse].capacity += push;
+            }
+            totalCost += push * distance[sink];
+        }
+    }
+
+private:
+    struct Edge {
+        size_t to;
+        size_t reverse;  // index of the paired edge in adjacency[to]
+        int64_t capacity;
+        double cost;
+    };
+
+    std::vector<std::vector<Edge>> adjacency;
+};
+
+// Minimal JSON document model for scenario files: null, booleans, numbers,
+// strings (standard escapes; \u limited to the Basic Latin range), arrays
+// and objects. Parsed once at startup, so clarity wins over speed here.
+class JsonValue {
+public:
+    enum class Type {
+        Null, Bool, Number, String, Array, Object
+    };
+
+    // The whole text must be one value; on failure error names the offset
+    static std::optional<JsonValue> parse(std::string_view text, std::string& error) {
+        Parser parser{text, 0, error};
+        JsonValue value;
+        if (!parser.parseValue(value, 0)) return std::nullopt;
+        parser.skipWhitespace();
+        if (parser.position != text.size()) {
+            parser.fail("trailing characters");
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    Type getType() const { return type; }
+    bool isNumber() const { return type == Type::Number; }
+    bool isString() const { return type == Type::String; }
+    bool isArray() const { return type == Type::Array; }
+    bool isObject() const { return type == Type::Object; }
+    double getNumber() const { return number; }
+    const std::string& getString() const { return text; }
+    const std::vector<JsonValue>& getItems() const { return items; }
+    const std::vector<std::string>& getKeys() const { return keys; }  // object keys, parallel to getItems()
+
+    const JsonValue* find(std::string_view key) const {
+        for (size_t k = 0; k < keys.size(); ++k) {
+            if (keys[k] == key) return &items[k];
+        }
+        return nullptr;
+    }
+
+private:
+    struct Parser {
+        std::string_view text;
+        size_t position;
+        std::string& error;
+
+        static constexpr int MAX_DEPTH = 64;
+
+        bool fail(const std::string& message) {
+            error = message + " at offset " + std::to_string(position);
+            return false;
+        }
+
+        void skipWhitespace() {
+            while (position < text.size() && text[position] && std::strchr(" \t\r\n", text[position])) {
+                ++position;
+            }
+        }
+
+        bool consume(std::string_view token) {
+            if (text.substr(position, token.size()) != token) return false;
+            position += token.size();
+            return true;
+        }
+
+        bool parseValue(JsonValue& value, int depth) {
+            if (depth > MAX_DEPTH) return fail("nesting too deep");
+            skipWhitespace();
+            if (position == text.size()) return fail("unexpected end of input");
+            char c = text[position];
+            if (c == '{') return parseObject(value, depth);
+            if (c == '[') return parseArray(value, depth);
+            if (c == '"') {
+                value.type = Type::String;
+                return parseString(value.text);
+            }
+            if (consume("true") || consume("false")) {
+                value.type = Type::Bool;
+                value.number = c == 't';
+                return true;
+            }
+            if (consume("null")) {
+                value.type = Type::Null;
+                return true;
+            }
+            return parseNumber(value);
+        }
+
+        bool parseNumber(JsonValue& value) {
+            size_t start = position;
+            if (position < text.size() && text[position] == '-') ++position;
+            while (position < text.size() && text[position] &&
+                   (std::isdigit(static_cast<unsigned char>(text[position])) || std::strchr(".eE+-", text[position]))) {
+                ++position;
+            }
+            std::string token(text.substr(start, position - start));
+            char* end = nullptr;
+            value.number = std::strtod(token.c_str(), &end);
+            if (token.empty() || end != token.c_str() + token.size() || !std::isfinite(value.number)) {
+                position = start;
+                return fail("invalid value");
+            }
+            value.type = Type::Number;
+            return true;
+        }
+
+        bool parseString(std::string& out) {
+            ++position;  // opening quote
+            out.clear();
+            while (position < text.size() && text[position] != '"') {
+                char c = text[position++];
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (position == text.size()) break;
+                char escape = text[position++];
+                switch (escape) {
+                    case '"': case '\\': case '/': out += escape; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        unsigned code = 0;
+                        auto digits = text.substr(position, 4);
+                        if (digits.size() != 4 || std::sscanf(std::string(digits).c_str(), "%4x", &code) != 1 ||
+                            code > 0x7F) {
+                            return fail("unsupported \\u escape");
+                        }
+                        out += static_cast<char>(code);
+                        position += 4;
+                        break;
+                    }
+                    default: return fail("invalid escape");
+                }
+            }
+            if (position == text.size()) return fail("unterminated string");
+            ++position;  // closing quote
+            return true;
+        }
+
+        bool parseArray(JsonValue& value, int depth) {
+            ++position;
+            value.type = Type::Array;
+            skipWhitespace();
+            if (consume("]")) return true;
+            while (true) {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1)) return false;
+                skipWhitespace();
+                if (consume("]")) return true;
+                if (!consume(",")) return fail("expected ',' or ']'");
+            }
+        }
+
+        bool parseObject(JsonValue& value, int depth) {
+            ++position;
+            value.type = Type::Object;
+            skipWhitespace();
+            if (consume("}")) return true;
+            while (true) {
+                skipWhitespace();
+                if (position == text.size() || text[position] != '"') return fail("expected a key");
+                value.keys.emplace_back();
+                if (!parseString(value.keys.back())) return false;
+                skipWhitespace();
+                if (!consume(":")) return fail("expected ':'");
+                value.items.emplace_back();
+                if (!parseValue(value.items.back(), depth + 1)) return false;
+                skipWhitespace();
+                if (consume("}")) return true;
+                if (!consume(",")) return fail("expected ',' or '}'");
+            }
+        }
+    };
+
+    Type type = Type::Null;
+    double number = 0;
+    std::string text;
+    std::vector<JsonValue> items;
+    std::vector<std::string> keys;
+};
+
+// Everything a run is built from: sites, slice pools and requirements, the
+// UE population and the run length. The defaults are the built-in four-site
+// scenario; a JSON scenario file overrides any subset of it (see
+// scenarios/default.json for every key), and unknown keys are rejected so a
+// typo cannot silently fall back to a default.
+struct Scenario {
+    struct Station {
+        static constexpr double MIN_FREQUENCY = 1e6;            // Hz
+        static constexpr double MIN_HEIGHT = UE_ANTENNA_HEIGHT;  // m
+
+        int id = 0;
+        double x = 0, y = 0;
+        double frequency = FREQUENCY_5G_LOW;  // Hz
+        double power = 40;                    // dBm
+        double height = 25.0;                 // m
+        int prbCount = DEFAULT_PRB_COUNT;
+        std::optional<NetworkSlice::ProfileSet> sliceProfiles;  // the band's pools if unset
+
+        // The checks the JSON reader applies key by key, for stations that
+        // arrive some other way; names the first violation, or nullptr.
+        const char* validate() const {
+            if (id < 1) return "id out of range";
+            if (!std::isfinite(x) || !std::isfinite(y)) return "position not finite";
+            if (!(frequency >= MIN_FREQUENCY && frequency <= std::numeric_limits<double>::max())) {
+                return "frequency out of range";
+            }
+            if (!std::isfinite(power)) return "power not finite";
+            if (!(height >= MIN_HEIGHT && height <= std::numeric_limits<double>::max())) return "height out of range";
+            if (prbCount < 1 || prbCount > static_cast<int>(MacScheduler::MAX_PRB_COUNT)) return "prbs out of range";
+            if (sliceProfiles) {
+                for (const NetworkSlice::Profile& profile : *sliceProfiles) {
+                    if (!(profile.priority >= 0 && profile.priority <= 1)) return "slice priority out of range";
+                    if (!(profile.bandwidth >= 0 && profile.bandwidth <= std::numeric_limits<double>::max())) {
+                        return "slice capacity out of range";
+                    }
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // UEs are placed uniformly over the area; slice type, speed and demand
+    // are drawn per UE from the seed
+    struct Population {
+        size_t count = 50;
+        double x = 0, y = 0, width = 1000, height = 1000;   // m
+        std::array<double, NetworkSlice::TYPE_COUNT> sliceMix = {0.7, 0.2, 0.1};
+        int minSpeed = 1, maxSpeed = 5;             // m/s
+        int minBandwidth = 5, maxBandwidth = 24;    // MHz
+        // Largest demand a scenario may give a UE, so a grant in kHz fits 32 bits
+        static constexpr double MAX_BANDWIDTH = 1e6;  // MHz
+
+        struct Ue {
+            double x, y;
+            float speed;
+            NetworkSlice::SliceType slice;
+            float bandwidth;
+        };
+
+        // UEs drawn ahead of time, e.g. mapped from a binary scenario; used
+        // instead of drawing from the seed. owner keeps the memory alive.
+        struct Columns {
+            size_t count = 0;
+            const double* x = nullptr;
+            const double* y = nullptr;
+            const float* speed = nullptr;
+            const NetworkSlice::SliceType* slice = nullptr;
+            const float* bandwidth = nullptr;
+            std::shared_ptr<const void> owner;
+        };
+        std::optional<Columns> drawn;
+
+        // UE ue (numbered from 1). Each attribute is its own counter draw, so
+        // a UE is a function of the seed and the scenario alone, and does not
+        // depend on how many others there are.
+        Ue draw(const CounterRng& rng, uint32_t ue) const {
+            using Stream = CounterRng::Stream;
+            if (drawn) {
+                size_t i = ue - 1;
+                return {drawn->x[i], drawn->y[i], drawn->speed[i], drawn->slice[i], drawn->bandwidth[i]};
+            }
+
+            double total = sliceMix[0] + sliceMix[1] + sliceMix[2];
+            double embbCut = sliceMix[0] / total;
+            double urllcCut = (sliceMix[0] + sliceMix[1]) / total;
+            double sliceDraw = rng.uniform(Stream::Population, ue, 0, 0);
+            NetworkSlice::SliceType type = sliceDraw < embbCut ? NetworkSlice::SliceType::eMBB
+                                         : sliceDraw < urllcCut ? NetworkSlice::SliceType::URLLC
+                                         : NetworkSlice::SliceType::mMTC;
+            return {x + width * rng.uniform(Stream::Population, ue, 1, 0),
+                    y + height * rng.uniform(Stream::Population, ue, 2, 0),
+                    static_cast<float>(rng.uniformInt(minSpeed, maxSpeed, Stream::Population, ue, 3, 0)),
+                    type,
+                    static_cast<float>(rng.uniformInt(minBandwidth, maxBandwidth, Stream::Population, ue, 4, 0))};
+        }
+    };
+
+    // id, x, y, frequency, power, height, PRBs, own slice pools
+    std::vector<Station> stations = {
+            {1, 0, 0, FREQUENCY_5G_LOW, 40, 25.0, DEFAULT_PRB_COUNT, std::nullopt},
+            {2, 1000, 1000, FREQUENCY_5G_HIGH, 30, 25.0, DEFAULT_PRB_COUNT, std::nullopt},
+            {3, 0, 1000, FREQUENCY_5G_LOW, 40, 25.0, DEFAULT_PRB_COUNT, std::nullopt},
+            {4, 1000, 0, FREQUENCY_5G_HIGH, 30, 25.0, DEFAULT_PRB_COUNT, std::nullopt}
+    };
+
+    // Per-gNB pools by band: mmWave carriers are wider, so they get more eMBB capacity
+    std::array<NetworkSlice::ProfileSet, 2> bandSliceProfiles = {{
+            {{{0.7, 40}, {0.9, 20}, {0.3, 60}}},   // FR1: eMBB, URLLC, mMTC
+            {{{0.7, 100}, {0.9, 30}, {0.3, 40}}}   // FR2
+    }};
+
+    UserEquipmentStore::SliceRequirementTable sliceRequirements = UserEquipmentStore::DEFAULT_SLICE_REQUIREMENTS;
+    UserEquipmentStore::HandoverParameters handover;
+    Population population;
+    int steps = 10;
+    std::optional<uint64_t> seed;
+
+    // A site coming on air (add, with the whole station) or going off air
+    // (the id of a live station) at time, in simulated seconds. Listed in
+    // time order; events at or after the end of the run never fire.
+    struct SiteEvent {
+        double time = 0;
+        bool add = false;
+        Station station;  // only the id matters for a removal
+    };
+    std::vector<SiteEvent> siteEvents;
+
+    // Replays siteEvents against stations: times may not go backwards, a
+    // removal must name a live site and an addition a free id. False with
+    // error naming the offending event.
+    bool checkSiteEvents(std::string& error) const {
+        std::vector<int> live;
+        for (const Station& station : stations) {
+            live.push_back(station.id);
+        }
+        std::sort(live.begin(), live.end());
+        double last = 0;
+        for (size_t k = 0; k < siteEvents.size(); ++k) {
+            const SiteEvent& event = siteEvents[k];
+            std::string where = "siteEvents[" + std::to_string(k) + "]";
+            if (!(event.time >= last && std::isfinite(event.time))) {
+                error = where + ": time out of order";
+                return false;
+            }
+            last = event.time;
+            auto found = std::lower_bound(live.begin(), live.end(), event.station.id);
+            bool isLive = found != live.end() && *found == event.station.id;
+            if (event.add == isLive) {
+                error = where + (event.add ? ": id already on air" : ": no such site on air");
+                return false;
+            }
+            if (event.add) {
+                live.insert(found, event.station.id);
+            } else {
+                live.erase(found);
+            }
+        }
+        return true;
+    }
+
+    // Reads path over the defaults; false with a message naming the
+    // offending key if the file is unreadable or invalid.
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::optional<JsonValue> root = JsonValue::parse(text, error);
+        if (!root) return false;
+        Reader reader{error};
+        return reader.readScenario(*root, *this);
+    }
+
+private:
+    // Applies a parsed document field by field. Every read names the key
+    // path it came from, so errors point at the line to fix.
+    struct Reader {
+        std::string& error;
+
+        bool fail(const std::string& where, const std::string& message) {
+            error = where + ": " + message;
+            return false;
+        }
+
+        bool checkKeys(const JsonValue& object, const std::string& where,
+                       std::initializer_list<std::string_view> allowed) {
+            if (!object.isObject()) return fail(where, "expected an object");
+            for (const std::string& key : object.getKeys()) {
+                if (std::find(allowed.begin(), allowed.end(), key) == allowed.end()) {
+                    return fail(where, "unknown key \"" + key + "\"");
+                }
+            }
+            return true;
+        }
+
+        bool readNumber(const JsonValue& object, std::string_view key, const std::string& where, double& out,
+                        double min = -std::numeric_limits<double>::max(),
+                        double max = std::numeric_limits<double>::max()) {
+            const JsonValue* value = object.find(key);
+            if (!value) return true;
+            std::string path = where + "." + std::string(key);
+            if (!value->isNumber()) return fail(path, "expected a number");
+            if (value->getNumber() < min || value->getNumber() > max) return fail(path, "out of range");
+            out = value->getNumber();
+            return true;
+        }
+
+        template <typename Integer>
+        bool readInteger(const JsonValue& object, std::string_view key, const std::string& where, Integer& out,
+                         double min, double max) {
+            double value = static_cast<double>(out);
+            if (!readNumber(object, key, where, value, min, max)) return false;
+            if (value != std::floor(value)) return fail(where + "." + std::string(key), "expected an integer");
+            out = static_cast<Integer>(value);
+            return true;
+        }
+
+        bool readSliceTable(const JsonValue& object, const std::string& where,
+                            const std::function<bool(NetworkSlice::SliceType, const JsonValue&,
+                                                     const std::string&)>& readEntry) {
+            if (!checkKeys(object, where, {"eMBB", "URLLC", "mMTC"})) return false;
+            for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+                auto sliceType = static_cast<NetworkSlice::SliceType>(type);
+                std::string name = NetworkSlice::typeName(sliceType);
+                if (const JsonValue* entry = object.find(name)) {
+                    if (!readEntry(sliceType, *entry, where + "." + name)) return false;
+                }
+            }
+            return true;
+        }
+
+        bool readProfiles(const JsonValue& object, const std::string& where, NetworkSlice::ProfileSet& profiles) {
+            return readSliceTable(object, where, [&](NetworkSlice::SliceType type, const JsonValue& entry,
+                                                     const std::string& path) {
+                NetworkSlice::Profile& profile = profiles[static_cast<size_t>(type)];
+                return checkKeys(entry, path, {"priority", "capacity"}) &&
+                       readNumber(entry, "priority", path, profile.priority, 0, 1) &&
+                       readNumber(entry, "capacity", path, profile.bandwidth, 0);
+            });
+        }
+
+        bool readStation(const JsonValue& object, const std::string& where, Scenario& scenario,
+                         Station& station) {
+            if (!checkKeys(object, where, {"id", "x", "y", "band", "frequency", "power", "height", "prbs",
+                                           "sliceProfiles"})) {
+                return false;
+            }
+            if (!object.find("id")) return fail(where, "missing \"id\"");
+            if (const JsonValue* band = object.find("band")) {
+                if (band->isString() && band->getString() == "FR1") {
+                    station.frequency = FREQUENCY_5G_LOW;
+                } else if (band->isString() && band->getString() == "FR2") {
+                    station.frequency = FREQUENCY_5G_HIGH;
+                } else {
+                    return fail(where + ".band", "expected \"FR1\" or \"FR2\"");
+                }
+            }
+            if (!readInteger(object, "id", where, station.id, 1, std::numeric_limits<int32_t>::max()) ||
+                !readNumber(object, "x", where, station.x) || !readNumber(object, "y", where, station.y) ||
+                !readNumber(object, "frequency", where, station.frequency, Station::MIN_FREQUENCY) ||
+                !readNumber(object, "power", where, station.power) ||
+                !readNumber(object, "height", where, station.height, Station::MIN_HEIGHT) ||
+                !readInteger(object, "prbs", where, station.prbCount, 1, MacScheduler::MAX_PRB_COUNT)) {
+                return false;
+            }
+            if (const JsonValue* profiles = object.find("sliceProfiles")) {
+                station.sliceProfiles =
+                        scenario.bandSliceProfiles[static_cast<size_t>(BaseStation::bandFor(station.frequency))];
+                if (!readProfiles(*profiles, where + ".sliceProfiles", *station.sliceProfiles)) return false;
+            }
+            return true;
+        }
+
+        // {"time": t, "add": {station}} or {"time": t, "remove": id}
+        bool readSiteEvent(const JsonValue& object, const std::string& where, Scenario& scenario,
+                           SiteEvent& event) {
+            if (!checkKeys(object, where, {"time", "add", "remove"})) return false;
+            if (!object.find("time")) return fail(where, "missing \"time\"");
+            const JsonValue* add = object.find("add");
+            if ((add != nullptr) == (object.find("remove") != nullptr)) {
+                return fail(where, "expected one of \"add\" or \"remove\"");
+            }
+            event.add = add != nullptr;
+            if (!readNumber(object, "time", where, event.time, 0)) return false;
+            return add ? readStation(*add, where + ".add", scenario, event.station)
+                       : readInteger(object, "remove", where, event.station.id, 1, std::numeric_limits<int32_t>::max());
+        }
+
+        bool readPopulation(const JsonValue& object, const std::string& where, Population& population) {
+            if (!checkKeys(object, where, {"count", "area", "sliceMix", "speed", "bandwidth"}) ||
+                !readInteger(object, "count", where, population.count, 0, std::numeric_limits<uint32_t>::max() - 1)) {
+                return false;
+            }
+            if (const JsonValue* area = object.find("area")) {
+                std::string path = where + ".area";
+                if (!checkKeys(*area, path, {"x", "y", "width", "height"}) ||
+                    !readNumber(*area, "x", path, population.x) || !readNumber(*area, "y", path, population.y) ||
+                    !readNumber(*area, "width", path, population.width, 0) ||
+                    !readNumber(*area, "height", path, population.height, 0)) {
+                    return false;
+                }
+            }
+            if (const JsonValue* mix = object.find("sliceMix")) {
+                if (!readSliceTable(*mix, where + ".sliceMix", [&](NetworkSlice::SliceType type,
+                                                                     const JsonValue& entry, const std::string& path) {
+                    if (!entry.isNumber() || entry.getNumber() < 0) return fail(path, "expected a share >= 0");
+                    population.sliceMix[static_cast<size_t>(type)] = entry.getNumber();
+                    return true;
+                })) {
+                    return false;
+                }
+                double total = population.sliceMix[0] + population.sliceMix[1] + population.sliceMix[2];
+                if (total <= 0) return fail(where + ".sliceMix", "shares must not all be zero");
+            }
+            for (auto [key, min, max] : {std::tuple{"speed", &population.minSpeed, &population.maxSpeed},
+                                         std::tuple{"bandwidth", &population.minBandwidth, &population.maxBandwidth}}) {
+                if (const JsonValue* range = object.find(key)) {
+                    std::string path = where + "." + key;
+                    if (!checkKeys(*range, path, {"min", "max"}) || !readInteger(*range, "min", path, *min, 0, 1e6) ||
+                        !readInteger(*range, "max", path, *max, 0, 1e6)) {
+                        return false;
+                    }
+                    if (*min > *max) return fail(path, "min exceeds max");
+                }
+            }
+            return true;
+        }
+
+        bool readScenario(const JsonValue& root, Scenario& scenario) {
+            if (!checkKeys(root, "scenario", {"steps", "seed", "stations", "siteEvents", "sliceProfiles",
+                                              "sliceRequirements", "handover", "population"}) ||
+                !readInteger(root, "steps", "scenario", scenario.steps, 0, std::numeric_limits<int32_t>::max())) {
+                return false;
+            }
+            if (root.find("seed")) {
+                uint64_t seed = scenario.seed.value_or(DEFAULT_SEED);
+                if (!readInteger(root, "seed", "scenario", seed, 0, 9007199254740992.0)) return false;
+                scenario.seed = seed;
+            }
+            // Band pools first, so stations without their own inherit the file's values
+            if (const JsonValue* bands = root.find("sliceProfiles")) {
+                if (!checkKeys(*bands, "sliceProfiles", {"FR1", "FR2"})) return false;
+                for (size_t band = 0; band < 2; ++band) {
+                    std::string name = band == 0 ? "FR1" : "FR2";
+                    const JsonValue* profiles = bands->find(name);
+                    if (profiles && !readProfiles(*profiles, "sliceProfiles." + name,
+                                                  scenario.bandSliceProfiles[band])) {
+                        return false;
+                    }
+                }
+            }
+            if (const JsonValue* requirements = root.find("sliceRequirements")) {
+                if (!readSliceTable(*requirements, "sliceRequirements", [&](NetworkSlice::SliceType type,
+                                                                            const JsonValue& entry,
+                                                                            const std::string& path) {
+                    auto& table = scenario.sliceRequirements[static_cast<size_t>(type)];
+                    return checkKeys(entry, path, {"minSinr", "minRsrp", "priority"}) &&
+                           readNumber(entry, "minSinr", path, table.minSinr) &&
+                           readNumber(entry, "minRsrp", path, table.minRsrp) &&
+                           readNumber(entry, "priority", path, table.bandwidthPriority, 0, 1);
+                })) {
+                    return false;
+                }
+            }
+            if (const JsonValue* handover = root.find("handover")) {
+                using Parameters = UserEquipmentStore::HandoverParameters;
+                Parameters& parameters = scenario.handover;
+                if (!checkKeys(*handover, "handover", {"a3Offset", "hysteresis", "timeToTrigger"}) ||
+                    !readNumber(*handover, "a3Offset", "handover", parameters.a3Offset, -Parameters::MAX_OFFSET,
+                                Parameters::MAX_OFFSET) ||
+                    !readNumber(*handover, "hysteresis", "handover", parameters.hysteresis, 0,
+                                Parameters::MAX_OFFSET) ||
+                    !readNumber(*handover, "timeToTrigger", "handover", parameters.timeToTrigger, 0,
+                                Parameters::MAX_TIME_TO_TRIGGER)) {
+                    return false;
+                }
+            }
+            if (const JsonValue* stations = root.find("stations")) {
+                if (!stations->isArray()) return fail("stations", "expected an array");
+                scenario.stations.assign(stations->getItems().size(), Station{});
+                for (size_t s = 0; s < scenario.stations.size(); ++s) {
+                    if (!readStation(stations->getItems()[s], "stations[" + std::to_string(s) + "]", scenario,
+                                     scenario.stations[s])) {
+                        return false;
+                    }
+                    for (size_t other = 0; other < s; ++other) {
+                        if (scenario.stations[other].id == scenario.stations[s].id) {
+                            return fail("stations[" + std::to_string(s) + "]", "duplicate id");
+                        }
+                    }
+                }
+            }
+            if (const JsonValue* siteEvents = root.find("siteEvents")) {
+                if (!siteEvents->isArray()) return fail("siteEvents", "expected an array");
+                scenario.siteEvents.assign(siteEvents->getItems().size(), SiteEvent{});
+                for (size_t k = 0; k < scenario.siteEvents.size(); ++k) {
+                    if (!readSiteEvent(siteEvents->getItems()[k], "siteEvents[" + std::to_string(k) + "]",
+                                       scenario, scenario.siteEvents[k])) {
+                        return false;
+                    }
+                }
+                if (!scenario.checkSiteEvents(error)) return false;
+            }
+            if (const JsonValue* population = root.find("population")) {
+                if (!readPopulation(*population, "population", scenario.population)) return false;
+            }
+            return true;
+        }
+    };
+};
+
+// Read-only view of a whole file: memory-mapped where the platform has
+// mmap, read into a page-aligned buffer otherwise.
+class MappedFile {
+public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#if SIM_HAS_MMAP
+        if (mapped) munmap(const_cast<std::byte*>(bytes), length);
+#endif
+        if (!mapped) ::operator delete(const_cast<std::byte*>(bytes), std::align_val_t{PAGE_ALIGNMENT});
+    }
+
+    static std::shared_ptr<const MappedFile> open(const std::string& path) {
+#if SIM_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat info{};
+        std::shared_ptr<MappedFile> file;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                file.reset(new MappedFile(static_cast<const std::byte*>(address), info.st_size, true));
+            }
+        }
+        ::close(fd);
+        return file;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        std::streamoff size = in ? static_cast<std::streamoff>(in.tellg()) : 0;
+        if (size <= 0) return nullptr;
+        auto* buffer = static_cast<std::byte*>(::operator new(size, std::align_val_t{PAGE_ALIGNMENT}));
+        std::shared_ptr<MappedFile> file(new MappedFile(buffer, static_cast<size_t>(size), false));
+        in.seekg(0);
+        if (!in.read(reinterpret_cast<char*>(buffer), size)) return nullptr;
+        return file;
+#endif
+    }
+
+    const std::byte* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    static constexpr size_t PAGE_ALIGNMENT = 4096;
+
+    MappedFile(const std::byte* data, size_t size, bool isMapped) : bytes(data), length(size), mapped(isMapped) {}
+
+    const std::byte* bytes;
+    size_t length;
+    bool mapped;
+};
+
+// Versioned binary scenario: the header holds everything a JSON scenario
+// does, followed by the station records and the pre-drawn UE population as
+// five 64-byte aligned columns (x, y, speed, slice, bandwidth). Opening one
+// maps the file and points the scenario's population at the columns in
+// place, so a 10M-UE scenario starts without parsing or drawing anything.
+// Written by --convert-scenario from any scenario the simulator can load.
+class ScenarioImage {
+public:
+    static constexpr size_t UE_COLUMN_COUNT = 5;
+
+    // True if path starts with the image magic; anything else is taken for JSON
+    static bool isImage(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[sizeof(FileHeader::magic)] = {};
+        return in.read(magic, sizeof(magic)) && std::memcmp(magic, FileHeader{}.magic, sizeof(magic)) == 0;
+    }
+
+    // Materializes the scenario's population (count UEs, drawn with rng
+    // unless already pre-drawn) and writes the whole scenario to path.
+    static bool write(const std::string& path, const Scenario& scenario, const CounterRng& rng, uint64_t seed,
+                      std::string& error) {
+        const Scenario::Population& population = scenario.population;
+        FileHeader header;
+        header.seed = seed;
+        header.steps = scenario.steps;
+        header.stationCount = static_cast<uint32_t>(scenario.stations.size());
+        header.ueCount = population.count;
+        header.area = {population.x, population.y, population.width, population.height};
+        header.sliceMix = population.sliceMix;
+        header.speedRange = {population.minSpeed, population.maxSpeed};
+        header.bandwidthRange = {population.minBandwidth, population.maxBandwidth};
+        header.bandSliceProfiles = scenario.bandSliceProfiles;
+        header.sliceRequirements = scenario.sliceRequirements;
+        header.handover = scenario.handover;
+
+        header.siteEventCount = static_cast<uint32_t>(scenario.siteEvents.size());
+
+        uint64_t offset = align(sizeof(FileHeader));
+        header.stationOffset = offset;
+        offset += header.stationCount * sizeof(StationRecord);
+        header.siteEventOffset = offset;
+        offset += header.siteEventCount * sizeof(SiteEventRecord);
+        for (size_t c = 0; c < UE_COLUMN_COUNT; ++c) {
+            offset = align(offset);
+            header.ueColumnOffset[c] = offset;
+            offset += header.ueCount * UE_COLUMN_WIDTH[c];
+        }
+        header.fileBytes = offset;
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            error = "cannot create " + path;
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.seekp(static_cast<std::streamoff>(header.stationOffset));
+        for (const Scenario::Station& station : scenario.stations) {
+            StationRecord record = toRecord(station);
+            file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        for (const Scenario::SiteEvent& event : scenario.siteEvents) {
+            SiteEventRecord record{event.time, event.add, 0, toRecord(event.station)};
+            file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+
+        // Drawn a block at a time so memory stays flat however large the population is
+        std::vector<double> x, y;
+        std::vector<float> speed, bandwidth;
+        std::vector<NetworkSlice::SliceType> slice;
+        for (uint64_t first = 0; first < header.ueCount; first += WRITE_BLOCK) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(WRITE_BLOCK, header.ueCount - first));
+            x.resize(count);
+            y.resize(count);
+            speed.resize(count);
+            slice.resize(count);
+            bandwidth.resize(count);
+            for (size_t k = 0; k < count; ++k) {
+                Scenario::Population::Ue ue = population.draw(rng, static_cast<uint32_t>(first + k + 1));
+                x[k] = ue.x;
+                y[k] = ue.y;
+                speed[k] = ue.speed;
+                slice[k] = ue.slice;
+                bandwidth[k] = ue.bandwidth;
+            }
+            const std::array<const void*, UE_COLUMN_COUNT> columns = {
+                    x.data(), y.data(), speed.data(), slice.data(), bandwidth.data()
+            };
+            for (size_t c = 0; c < UE_COLUMN_COUNT; ++c) {
+                file.seekp(static_cast<std::streamoff>(header.ueColumnOffset[c] + first * UE_COLUMN_WIDTH[c]));
+                file.write(static_cast<const char*>(columns[c]),
+                           static_cast<std::streamsize>(count * UE_COLUMN_WIDTH[c]));
+            }
+        }
+        // Pad an empty tail column out to the size the header promises
+        file.seekp(0, std::ios::end);
+        if (static_cast<uint64_t>(file.tellp()) < header.fileBytes) {
+            file.seekp(static_cast<std::streamoff>(header.fileBytes - 1));
+            file.put('\0');
+        }
+        if (!file.flush()) {
+            error = "cannot write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // Maps path and fills scenario from it; the population's columns point
+    // into the mapping, which they keep alive. false with a message if the
+    // file is not a complete image of this version.
+    static bool load(const std::string& path, Scenario& scenario, std::string& error) {
+        std::shared_ptr<const MappedFile> file = MappedFile::open(path);
+        if (!file) {
+            error = "cannot map " + path;
+            return false;
+        }
+        FileHeader header;
+        if (file->size() < sizeof(header)) {
+            error = "truncated header";
+            return false;
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0) {
+            error = "not a binary scenario";
+            return false;
+        }
+        if (header.version != FileHeader{}.version || header.byteOrder != FileHeader{}.byteOrder) {
+            error = "unsupported version or byte order";
+            return false;
+        }
+        if (header.fileBytes != file->size() ||
+            !fits(header.stationOffset, header.stationCount, sizeof(StationRecord), file->size()) ||
+            !fits(header.siteEventOffset, header.siteEventCount, sizeof(SiteEventRecord), file->size())) {
+            error = "truncated file";
+            return false;
+        }
+        for (size_t c = 0; c < UE_COLUMN_COUNT; ++c) {
+            if (header.ueColumnOffset[c] % ALIGNMENT != 0 ||
+                !fits(header.ueColumnOffset[c], header.ueCount, UE_COLUMN_WIDTH[c], file->size())) {
+                error = "truncated file";
+                return false;
+            }
+        }
+        // UE ids are 32-bit, as for a JSON population.count
+        if (header.ueCount > std::numeric_limits<uint32_t>::max() - 1 || header.steps < 0) {
+            error = "UE count or steps out of range";
+            return false;
+        }
+
+        scenario.seed = header.seed;
+        scenario.steps = header.steps;
+        scenario.bandSliceProfiles = header.bandSliceProfiles;
+        scenario.sliceRequirements = header.sliceRequirements;
+        scenario.handover = header.handover;
+        if (!scenario.handover.valid()) {
+            error = "handover parameters out of range";
+            return false;
+        }
+        scenario.stations.resize(header.stationCount);
+        std::vector<int> ids(header.stationCount);
+        for (uint32_t s = 0; s < header.stationCount; ++s) {
+            StationRecord record;
+            std::memcpy(&record, file->data() + header.stationOffset + s * sizeof(StationRecord), sizeof(record));
+            Scenario::Station& station = scenario.stations[s];
+            station = fromRecord(record);
+            if (const char* problem = station.validate()) {
+                error = "station record " + std::to_string(s) + ": " + problem;
+                return false;
+            }
+            ids[s] = station.id;
+        }
+        std::sort(ids.begin(), ids.end());
+        if (auto duplicate = std::adjacent_find(ids.begin(), ids.end()); duplicate != ids.end()) {
+            error = "duplicate station id " + std::to_string(*duplicate);
+            return false;
+        }
+        scenario.siteEvents.resize(header.siteEventCount);
+        for (uint32_t k = 0; k < header.siteEventCount; ++k) {
+            SiteEventRecord record;
+            std::memcpy(&record, file->data() + header.siteEventOffset + k * sizeof(SiteEventRecord),
+                        sizeof(record));
+            Scenario::SiteEvent& event = scenario.siteEvents[k];
+            event = {record.time, record.add != 0, fromRecord(record.station)};
+            const char* problem = event.add ? event.station.validate()
+                                            : event.station.id < 1 ? "id out of range" : nullptr;
+            if (problem) {
+                error = "site event record " + std::to_string(k) + ": " + problem;
+                return false;
+            }
+        }
+        if (!scenario.checkSiteEvents(error)) return false;
+
+        Scenario::Population& population = scenario.population;
+        population.count = header.ueCount;
+        population.x = header.area[0];
+        population.y = header.area[1];
+        population.width = header.area[2];
+        population.height = header.area[3];
+        population.sliceMix = header.sliceMix;
+        population.minSpeed = header.speedRange[0];
+        population.maxSpeed = header.speedRange[1];
+        population.minBandwidth = header.bandwidthRange[0];
+        population.maxBandwidth = header.bandwidthRange[1];
+
+        auto column = [&](size_t c) { return file->data() + header.ueColumnOffset[c]; };
+        Scenario::Population::Columns drawn;
+        drawn.count = header.ueCount;
+        drawn.x = reinterpret_cast<const double*>(column(0));
+        drawn.y = reinterpret_cast<const double*>(column(1));
+        drawn.speed = reinterpret_cast<const float*>(column(2));
+        drawn.slice = reinterpret_cast<const NetworkSlice::SliceType*>(column(3));
+        drawn.bandwidth = reinterpret_cast<const float*>(column(4));
+        // Slice types index per-type tables, so a corrupt byte must not get through
+        auto* sliceBytes = reinterpret_cast<const uint8_t*>(column(3));
+        if (std::any_of(sliceBytes, sliceBytes + header.ueCount,
+                        [](uint8_t type) { return type >= NetworkSlice::TYPE_COUNT; })) {
+            error = "invalid slice type in UE column";
+            return false;
+        }
+        // Demands bound the grants the UE store keeps in 32 bits, as they do for JSON
+        if (!std::all_of(drawn.bandwidth, drawn.bandwidth + header.ueCount, [](float demand) {
+                return demand >= 0 && demand <= Scenario::Population::MAX_BANDWIDTH;
+            })) {
+            error = "invalid bandwidth in UE column";
+            return false;
+        }
+        drawn.owner = file;
+        population.drawn = std::move(drawn);
+        return true;
+    }
+
+private:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t WRITE_BLOCK = 65536;
+    static constexpr std::array<size_t, UE_COLUMN_COUNT> UE_COLUMN_WIDTH = {
+            sizeof(double), sizeof(double), sizeof(float), sizeof(NetworkSlice::SliceType), sizeof(float)
+    };
+
+    struct FileHeader {
+        char magic[8] = {'5', 'G', 'S', 'C', 'E', 'N', '\0', '\0'};
+        uint32_t version = 3;
+        uint32_t byteOrder = 0x01020304;  // reads back swapped on a host of the other endianness
+        uint64_t fileBytes = 0;
+        uint64_t seed = 0;
+        int32_t steps = 0;
+        uint32_t stationCount = 0;
+        uint64_t ueCount = 0;
+        uint64_t stationOffset = 0;
+        uint32_t siteEventCount = 0;
+        uint32_t reserved = 0;
+        uint64_t siteEventOffset = 0;
+        std::array<uint64_t, UE_COLUMN_COUNT> ueColumnOffset{};
+        std::array<double, 4> area{};  // x, y, width, height of the drawn population
+        std::array<double, NetworkSlice::TYPE_COUNT> sliceMix{};
+        std::array<int32_t, 2> speedRange{};
+        std::array<int32_t, 2> bandwidthRange{};
+        std::array<NetworkSlice::ProfileSet, 2> bandSliceProfiles{};
+        UserEquipmentStore::SliceRequirementTable sliceRequirements{};
+        UserEquipmentStore::HandoverParameters handover{};
+    };
+
+    struct StationRecord {
+        int32_t id;
+        int32_t prbCount;
+        double x, y;
+        double frequency;  // Hz
+        double power;      // dBm
+        double height;     // m
+        uint32_t hasSliceProfiles;
+        uint32_t reserved;
+        NetworkSlice::ProfileSet sliceProfiles;
+    };
+
+    struct SiteEventRecord {
+        double time;
+        uint32_t add;
+        uint32_t reserved;
+        StationRecord station;  // only the id for a removal
+    };
+
+    static_assert(std::is_trivially_copyable_v<FileHeader> && std::is_trivially_copyable_v<StationRecord> &&
+                  std::is_trivially_copyable_v<SiteEventRecord>);
+    static_assert(sizeof(NetworkSlice::SliceType) == 1);
+
+    static uint64_t align(uint64_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+
+    static StationRecord toRecord(const Scenario::Station& station) {
+        StationRecord record{};
+        record.id = station.id;
+        record.prbCount = station.prbCount;
+        record.x = station.x;
+        record.y = station.y;
+        record.frequency = station.frequency;
+        record.power = station.power;
+        record.height = station.height;
+        record.hasSliceProfiles = station.sliceProfiles.has_value();
+        record.sliceProfiles = station.sliceProfiles.value_or(NetworkSlice::ProfileSet{});
+        return record;
+    }
+
+    static Scenario::Station fromRecord(const StationRecord& record) {
+        Scenario::Station station{record.id, record.x, record.y, record.frequency, record.power, record.height,
+                                  record.prbCount, std::nullopt};
+        if (record.hasSliceProfiles) station.sliceProfiles = record.sliceProfiles;
+        return station;
+    }
+
+    // Whether count items of width bytes from offset lie within size bytes.
+    // Compares by division so a crafted offset or count cannot wrap around.
+    static bool fits(uint64_t offset, uint64_t count, uint64_t width, uint64_t size) {
+        return offset <= size && count <= (size - offset) / width;
+    }
+};
+
+class FiveGNetwork {
+public:
+    explicit FiveGNetwork(size_t threadCount = std::max(1u, std::thread::hardware_concurrency()),
+                          uint64_t seed = DEFAULT_SEED)
+            : rng(seed), pool(threadCount) {
+        ues.setEventLog(&eventLog);
+    }
+
+    void initialize() {
+        for (const Scenario::Station& site : scenario.stations) {
+            placeStation(site);
+        }
+        SIM_LOG(Status, Summary) {
+            std::cout << "Created " << baseStations.size() << " base stations\n"
+                      << "Created " << slices.size() << " network slices\n";
+        }
+        stationGrid.build(baseStations, coverageThreshold());
+        createUserEquipment();
+    }
+
+    // Sites, slice pools, requirements, handover parameters and population
+    // initialize() builds from; call before initialize(). Without it the
+    // built-in defaults apply.
+    void setScenario(const Scenario& value) {
+        scenario = value;
+        for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+            ues.setSliceRequirements(static_cast<NetworkSlice::SliceType>(type), scenario.sliceRequirements[type]);
+        }
+        handoverParameters = scenario.handover;
+    }
+
+    // Brings a new site on air with every network slice; may be called between
+    // events mid-run, and UEs start seeing it from their next measurement.
+    StationHandle addBaseStation(const Scenario::Station& site) {
+        StationHandle handle = placeStation(site);
+        // Per-cell state grows with the slot map, so a later swap-remove finds
+        // this station's entries where the slot map keeps the station
+        scheduler.resize(ues.size(), baseStations.size());
+        cellBits.resize(baseStations.size(), 0);
+        if (kpiFile.isOpen()) {
+            kpiCounters.resize((baseStations.size() + 1) * NetworkSlice::TYPE_COUNT);
+        }
+        stationGrid.build(baseStations, coverageThreshold());
+        ues.invalidateMeasurements();
+        return handle;
+    }
+
+    // Site outage: UEs served by the station are released and re-attach
+    // elsewhere. Handles held for it elsewhere simply stop resolving.
+    bool removeBaseStation(StationHandle handle) {
+        if (!baseStations.contains(handle)) return false;
+        for (size_t i = 0; i < ues.size(); ++i) {
+            if (ues.getServingStation(i) == handle) {
+                ues.disconnect(i, baseStations, slices);
+                if (!attachPending.empty()) {
+                    scheduleAttach(events.now(), static_cast<int>(i));
+                }
+            }
+        }
+        for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+            slices.erase(baseStations.get(handle)->getSlice(static_cast<NetworkSlice::SliceType>(type)));
+        }
+        // Per-cell state is kept by dense index, so it follows the swap-remove
+        size_t dense = baseStations.indexOf(handle);
+        scheduler.removeCell(dense);
+        if (dense < cellBits.size()) {
+            cellBits[dense] = cellBits.back();
+            cellBits.pop_back();
+        }
+        if (kpiFile.isOpen()) {
+            // Mirror the slot map's swap-remove; the station's partial step is
+            // dropped. Counters are only sized once something is counted.
+            size_t removed = (dense + 1) * NetworkSlice::TYPE_COUNT;
+            size_t last = baseStations.size() * NetworkSlice::TYPE_COUNT;
+            kpiCounters.resize(last + NetworkSlice::TYPE_COUNT);
+            std::copy_n(kpiCounters.begin() + last, NetworkSlice::TYPE_COUNT, kpiCounters.begin() + removed);
+            kpiCounters.resize(last);
+        }
+        baseStations.erase(handle);
+        stationGrid.build(baseStations, coverageThreshold());
+        ues.invalidateMeasurements();
+        return true;
+    }
+
+    // When enabled, event processing is held back until wall-clock time catches
+    // up with simulated time. Off by default so runs finish as fast as possible.
+    void setRealTimePacing(bool enabled) {
+        realTimePacing = enabled;
+    }
+
+    void setSchedulerPolicy(MacScheduler::Policy policy) {
+        scheduler.setPolicy(policy);
+    }
+
+    enum class AdmissionMode {
+        Greedy,         // priority-ordered commits
+        ValidateFlow    // greedy, plus a min-cost-flow bound printed per batch
+    };
+
+    void setAdmissionMode(AdmissionMode mode) {
+        admissionMode = mode;
+    }
+
+    // A3 and time-to-trigger settings; the scenario's "handover" block sets
+    // them too, so call after setScenario() to override it.
+    void setHandoverParameters(const UserEquipmentStore::HandoverParameters& parameters) {
+        handoverParameters = parameters;
+    }
+
+    // Appends per-step, per-cell, per-slice KPIs to a columnar file at path;
+    // false if the file cannot be created. Complete once the run returns.
+    bool setKpiFile(const std::string& path, bool compress) {
+        return kpiFile.open(path, compress);
+    }
+
+    // Sends per-UE events to a binary log at path instead of stdout; false
+    // if the file cannot be created. The log is complete once the run returns.
+    bool setEventLogFile(const std::string& path) {
+        return eventLog.open(path);
+    }
+
+    void setMeasurementRefreshDistance(double meters) {
+        ues.setMeasurementRefreshDistance(meters);
+    }
+
+    void runSimulation(int steps) {
+        using EventType = EventQueue::EventType;
+
+        endTime = steps * STEP_DURATION;
+        if (steps > 0) ues.materialize();
+        attachPending.assign(ues.size(), 0);
+
+        size_t nextSiteEvent = 0;
+        for (int i = 0; i < steps; ++i) {
+            events.schedule(i * STEP_DURATION, EventType::StepBegin);
+            // Site changes due by the end of this step; one due at its start
+            // lands before the UEs move
+            while (nextSiteEvent < scenario.siteEvents.size() &&
+                   EventQueue::toTicks(scenario.siteEvents[nextSiteEvent].time) <
+                   EventQueue::toTicks((i + 1) * STEP_DURATION)) {
+                events.schedule(scenario.siteEvents[nextSiteEvent].time, EventType::SiteChange,
+                                static_cast<int>(nextSiteEvent));
+                nextSiteEvent++;
+            }
+            events.schedule(i * STEP_DURATION, EventType::Move);
+            events.schedule(i * STEP_DURATION, EventType::Measure);
+            events.schedule((i + 1) * STEP_DURATION, EventType::MacSchedule);
+            events.schedule((i + 1) * STEP_DURATION, EventType::StatusReport);
+        }
+
+        auto wallStart = std::chrono::steady_clock::now();
+        std::vector<EventQueue::Event> batch;
+        while (!events.empty()) {
+            // Events of the same type due at the same instant are handled as one batch
+            batch.assign(1, events.pop());
+            while (!events.empty() && events.peek().tick == batch.front().tick &&
+                   events.peek().type == batch.front().type) {
+                batch.push_back(events.pop());
+            }
+
+            if (realTimePacing) {
+                std::this_thread::sleep_until(wallStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double>(batch.front().time)));
+            }
+
+            handleEvents(batch);
+        }
+        eventLog.close();
+        kpiFile.close();
+    }
+
+private:
+    void handleEvents(const std::vector<EventQueue::Event>& batch) {
+        using EventType = EventQueue::EventType;
+        const double time = batch.front().time;
+        const uint32_t step = stepAt(time);
+        eventLog.setClock(time);
+
+        switch (batch.front().type) {
+            case EventType::StepBegin:
+                SIM_LOG(Status, Summary) std::cout << "\n=== Simulation Step " << step + 1 << " ===\n";
+                break;
+
+            case EventType::SiteChange:
+                for (const auto& event : batch) {
+                    const Scenario::SiteEvent& change = scenario.siteEvents[event.ueIndex];
+                    bool applied = change.add ? addBaseStation(change.station).isValid()
+                                              : removeBaseStation(findStation(change.station.id));
+                    SIM_LOG(Status, Summary) {
+                        std::cout << "gNB " << change.station.id << (change.add ? " on air" : " off air")
+                                  << (applied ? "\n" : " (ignored)\n");
+                    }
+                }
+                break;
+
+            case EventType::Move:
+                // UEs left off the report list report from their cache unchanged
+                measurementsReused += pool.parallelCollect(
+                        ues.size(), PARALLEL_THRESHOLD, reportingUes,
+                        [this, step](size_t begin, size_t end, std::vector<uint32_t>& due) {
+                            return ues.move(begin, end, STEP_DURATION, rng, step, due);
+                        });
+
+                // Idle UEs queue an attach now; sessions drawn for release
+                // end after this step's reports, see Measure
+                pool.parallelCollect(ues.size(), PARALLEL_THRESHOLD, sessionChanges,
+                                     [this, step](size_t begin, size_t end, std::vector<uint32_t>& changed) {
+                    for (size_t i = begin; i < end; ++i) {
+                        if (!ues.isConnected(i) ||
+                            rng.uniform(CounterRng::Stream::SessionRelease, ues.getId(i), step, 0) <
+                            SESSION_RELEASE_PROBABILITY) {
+                            changed.push_back(static_cast<uint32_t>(i));
+                        }
+                    }
+                    return size_t{0};
+                });
+                releasingUes.clear();
+                for (uint32_t i : sessionChanges) {
+                    if (ues.isConnected(i)) {
+                        releasingUes.push_back(i);
+                    } else {
+                        scheduleAttach(time, static_cast<int>(i));
+                    }
+                }
+                break;
+
+            case EventType::Measure:
+                processMeasurements(time);
+                for (uint32_t i : releasingUes) {
+                    ues.disconnect(i, baseStations, slices);
+                    scheduleAttach(time, static_cast<int>(i));
+                }
+                releasingUes.clear();
+                break;
+
+            case EventType::ConnectAttempt:
+                // One event per instant; the UEs due then wait in attachQueue
+                if (auto due = attachQueue.extract(batch.front().tick)) {
+                    processAttachBatch(due.mapped(), time);
+                }
+                break;
+
+            case EventType::MacSchedule:
+                // Due at the end of a step: runs that step's TTIs over the
+                // cell membership it ended with
+                scheduleStep(step - 1);
+                break;
+
+            case EventType::StatusReport:
+                if (kpiFile.isOpen()) {
+                    recordKpis(step - 1);
+                }
+                displayStatus();
+                break;
+        }
+    }
+
+    // Connected UEs report on their serving cell and its neighbour list once
+    // per step, after moving. Only the UEs move() listed can report anything
+    // new, so only they are visited; of those, only UEs that moved far enough
+    // re-measure. Reports are built and each UE's timers run in parallel;
+    // the handovers and link failures that fall due are then carried out in
+    // UE order, so they contend for slices the same way on every run.
+    void processMeasurements(double time) {
+        const uint32_t step = stepAt(time);
+        const StationBlock& stations = stationGrid.stations();
+        reports.assign(reportingUes.size(), UserEquipmentStore::MeasurementReport{});
+        reportActions.assign(reportingUes.size(), 0);
+
+        pool.parallelCollect(reportingUes.size(), PARALLEL_THRESHOLD, pendingReports,
+                             [&](size_t begin, size_t end, std::vector<uint32_t>& pending) {
+            size_t refreshed = 0, reused = 0;
+            for (size_t k = begin; k < end; ++k) {
+                size_t i = reportingUes[k];
+                StationHandle serving = ues.getServingStation(i);
+                if (ues.isConnected(i) && baseStations.contains(serving)) {
+                    uint32_t position = stations.positionOfDense[baseStations.indexOf(serving)];
+                    if (ues.measureNeighbours(i, position, stations)) {
+                        refreshed++;
+                    } else {
+                        reused++;
+                    }
+                    reports[k] = ues.reportNeighbours(i, stations);
+                    reportActions[k] = ues.updateLinkState(i, reports[k], step, handoverParameters);
+                    if (reportActions[k]) pending.push_back(static_cast<uint32_t>(k));
+                }
+            }
+            measurementsRefreshed += refreshed;
+            measurementsReused += reused;
+            return size_t{0};
+        });
+
+        for (uint32_t k : pendingReports) {
+            size_t i = reportingUes[k];
+            StationHandle serving = ues.getServingStation(i);
+            auto outcome = ues.completeLinkState(i, reportActions[k], reports[k], step, baseStations, slices);
+            switch (outcome) {
+                case UserEquipmentStore::HandoverOutcome::HandedOver: handovers++; break;
+                case UserEquipmentStore::HandoverOutcome::Failed: failedHandovers++; break;
+                case UserEquipmentStore::HandoverOutcome::RadioLinkFailure:
+                    radioLinkFailures++;
+                    scheduleAttach(time, static_cast<int>(i));
+                    break;
+                case UserEquipmentStore::HandoverOutcome::None: break;
+            }
+            if (kpiFile.isOpen() && outcome != UserEquipmentStore::HandoverOutcome::None) {
+                KpiCounters& counters = kpiCountersFor(serving, ues.getRequiredSlice(i));
+                counters.handovers += outcome == UserEquipmentStore::HandoverOutcome::HandedOver;
+                counters.handoverFailures += outcome == UserEquipmentStore::HandoverOutcome::Failed;
+                counters.radioLinkFailures += outcome == UserEquipmentStore::HandoverOutcome::RadioLinkFailure;
+            }
+        }
+    }
+
+    // Stable counting sort of UEs into buckets, bucketOf(i) giving UE i's
+    // bucket or NO_BUCKET to leave it out. Each worker counts, and later
+    // places, one fixed range of UEs, with offsets laid out per range in UE
+    // order, so members lists every bucket's UEs in UE order for any thread
+    // count; bucket b is members[start[b], start[b + 1]).
+    static constexpr uint32_t NO_BUCKET = std::numeric_limits<uint32_t>::max();
+
+    template <typename BucketOf>
+    void bucketUes(size_t buckets, std::vector<uint32_t>& start, std::vector<uint32_t>& members,
+                   BucketOf&& bucketOf) {
+        const size_t count = ues.size();
+        const size_t parts = count < PARALLEL_THRESHOLD ? 1 : pool.size();
+        const size_t partSize = (count + parts - 1) / std::max<size_t>(parts, 1);
+        ueBucket.resize(count);
+        partOffsets.assign(parts * buckets, 0);
+        auto forEachPart = [&](auto&& fn) {
+            pool.parallelFor(parts, 2, [&](size_t first, size_t last) {
+                for (size_t p = first; p < last; ++p) {
+                    fn(p, p * partSize, std::min((p + 1) * partSize, count));
+                }
+            });
+        };
+
+        forEachPart([&](size_t p, size_t begin, size_t end) {
+            uint32_t* counts = &partOffsets[p * buckets];
+            for (size_t i = begin; i < end; ++i) {
+                ueBucket[i] = bucketOf(i);
+                if (ueBucket[i] != NO_BUCKET) counts[ueBucket[i]]++;
+            }
+        });
+        start.resize(buckets + 1);
+        uint32_t total = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            start[b] = total;
+            for (size_t p = 0; p < parts; ++p) {
+                uint32_t partCount = partOffsets[p * buckets + b];
+                partOffsets[p * buckets + b] = total;
+                total += partCount;
+            }
+        }
+        start[buckets] = total;
+
+        members.resize(total);
+        forEachPart([&](size_t p, size_t begin, size_t end) {
+            uint32_t* cursor = &partOffsets[p * buckets];
+            for (size_t i = begin; i < end; ++i) {
+                if (ueBucket[i] != NO_BUCKET) members[cursor[ueBucket[i]]++] = static_cast<uint32_t>(i);
+            }
+        });
+    }
+
+    // Buckets connected UEs by serving cell, then schedules every cell for the
+    // step's slots in parallel.
+    void scheduleStep(uint32_t step) {
+        const size_t cellCount = baseStations.size();
+        scheduler.resize(ues.size(), cellCount);
+
+        bucketUes(cellCount, cellUeStart, cellUes, [this](size_t i) {
+            return ues.isConnected(i) ? static_cast<uint32_t>(baseStations.indexOf(ues.getServingStation(i)))
+                                      : NO_BUCKET;
+        });
+        cellSinr.resize(cellUes.size());
+        pool.parallelFor(cellUes.size(), PARALLEL_THRESHOLD, [this](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                cellSinr[k] = ues.getCurrentSignal(cellUes[k]);
+            }
+        });
+
+        cellBits.assign(cellCount, 0);
+        pool.parallelFor(cellCount, 2, [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; ++c) {
+                size_t first = cellUeStart[c];
+                cellBits[c] = scheduler.runCell(c, cellUes.data() + first, cellSinr.data() + first,
+                                                cellUeStart[c + 1] - first, baseStations[c].getPrbCount(),
+                                                uint64_t{step} * SLOTS_PER_STEP, SLOTS_PER_STEP, rng);
+            }
+        });
+    }
+
+    // Two-phase attach: every UE in the batch evaluates candidates in parallel
+    // against a frozen resource picture, then proposals are committed one by one
+    // in scheduling order so contention on a slice resolves the same way on
+    // every run regardless of thread count.
+    void processAttachBatch(const std::vector<uint32_t>& batch, double time) {
+        proposals.resize(batch.size());
+
+        // Evaluate in grid-cell order so UEs that share a neighbourhood are
+        // measured together; commits below still follow scheduling order.
+        attachCells.resize(batch.size());
+        attachOrder.resize(batch.size());
+        for (size_t k = 0; k < batch.size(); ++k) {
+            attachCells[k] = stationGrid.cellIndex(ues.getX(batch[k]), ues.getY(batch[k]));
+            attachOrder[k] = static_cast<uint32_t>(k);
+        }
+        std::stable_sort(attachOrder.begin(), attachOrder.end(),
+                         [this](uint32_t a, uint32_t b) { return attachCells[a] < attachCells[b]; });
+
+        pool.parallelFor(batch.size(), PARALLEL_THRESHOLD, [&](size_t begin, size_t end) {
+            // Measure the stale UEs of a same-cell block against their shared
+            // station ranges in one kernel call per range, then let every UE
+            // pick from its cached row. Retries that have not moved skip the kernel.
+            thread_local std::vector<float> blockX, blockY, rsrp;
+            thread_local std::vector<uint32_t> members, stale;
+            const StationBlock& stations = stationGrid.stations();
+            size_t refreshed = 0;
+            size_t blockBegin = begin;
+            while (blockBegin < end) {
+                uint32_t cell = attachCells[attachOrder[blockBegin]];
+                size_t blockEnd = blockBegin + 1;
+                while (blockEnd < end && blockEnd - blockBegin < MEASUREMENT_BLOCK &&
+                       attachCells[attachOrder[blockEnd]] == cell) {
+                    ++blockEnd;
+                }
+
+                stale.clear();
+                for (size_t u = blockBegin; u < blockEnd; ++u) {
+                    uint32_t ueIndex = batch[attachOrder[u]];
+                    if (ues.needsMeasurement(ueIndex, UserEquipmentStore::ATTACH_KEY)) {
+                        stale.push_back(ueIndex);
+                    }
+                }
+
+                if (!stale.empty()) {
+                    StationGrid::Neighbourhood ranges;
+                    size_t rangeCount = stationGrid.neighbourhood(cell, ranges);
+                    members.clear();
+                    for (size_t r = 0; r < rangeCount; ++r) {
+                        for (uint32_t s = ranges[r].begin; s < ranges[r].end; ++s) {
+                            members.push_back(s);
+                        }
+                    }
+
+                    blockX.resize(stale.size());
+                    blockY.resize(stale.size());
+                    rsrp.resize(stale.size() * members.size());
+                    for (size_t u = 0; u < stale.size(); ++u) {
+                        blockX[u] = static_cast<float>(ues.getX(stale[u]));
+                        blockY[u] = static_cast<float>(ues.getY(stale[u]));
+                    }
+                    size_t offset = 0;
+                    for (size_t r = 0; r < rangeCount; ++r) {
+                        SignalKernel::measure(blockX.data(), blockY.data(), stale.size(), stations,
+                                              ranges[r].begin, ranges[r].end, rsrp.data() + offset, members.size());
+                        offset += ranges[r].end - ranges[r].begin;
+                    }
+                    for (size_t u = 0; u < stale.size(); ++u) {
+                        ues.storeMeasurement(stale[u], UserEquipmentStore::ATTACH_KEY, members.data(),
+                                             members.size(), &rsrp[u * members.size()], stations);
+                    }
+                    refreshed += stale.size();
+                }
+
+                for (size_t u = blockBegin; u < blockEnd; ++u) {
+                    size_t k = attachOrder[u];
+                    proposals[k] = ues.proposeConnection(batch[k], stations, slices);
+                }
+                blockBegin = blockEnd;
+            }
+            measurementsRefreshed += refreshed;
+            measurementsReused += (end - begin) - refreshed;
+        });
+
+        // Admit the batch as a whole: heavier slices first, then within a slice
+        // the smallest requests (so more UEs fit), then UEs with the fewest
+        // alternatives. Scheduling order only breaks exact ties, so an early
+        // low-priority request can no longer starve a later URLLC one.
+        admissionOrder.resize(batch.size());
+        for (size_t k = 0; k < batch.size(); ++k) {
+            admissionOrder[k] = static_cast<uint32_t>(k);
+        }
+        std::stable_sort(admissionOrder.begin(), admissionOrder.end(), [&](uint32_t a, uint32_t b) {
+            double weightA = ues.getAdmissionWeight(batch[a]);
+            double weightB = ues.getAdmissionWeight(batch[b]);
+            if (weightA != weightB) return weightA > weightB;
+            double demandA = ues.getRequiredBandwidth(batch[a]);
+            double demandB = ues.getRequiredBandwidth(batch[b]);
+            if (demandA != demandB) return demandA < demandB;
+            return proposals[a].size() < proposals[b].size();
+        });
+
+        double boundWeight = 0;
+        if (admissionMode == AdmissionMode::ValidateFlow) {
+            boundWeight = admissionFlowBound(batch);
+        }
+
+        double admittedWeight = 0;
+        size_t admitted = 0;
+        for (uint32_t k : admissionOrder) {
+            uint32_t ueIndex = batch[k];
+            attachPending[ueIndex] = 0;
+
+            bool connected = ues.commitConnection(ueIndex, proposals[k], baseStations, slices);
+            if (connected) {
+                admittedWeight += ues.getAdmissionWeight(ueIndex);
+                admitted++;
+            } else if (ues.canRetry(ueIndex)) {
+                scheduleAttach(time + BACKOFF_INTERVAL * ues.getConnectionAttempts(ueIndex), static_cast<int>(ueIndex));
+            }
+            if (kpiFile.isOpen()) {
+                // Counted against the cell joined, else the best candidate
+                StationHandle station = connected ? ues.getServingStation(ueIndex) : proposals[k].best().station;
+                KpiCounters& counters = kpiCountersFor(station, ues.getRequiredSlice(ueIndex));
+                counters.attachAttempts++;
+                counters.attachFailures += !connected;
+            }
+        }
+
+        if (admissionMode == AdmissionMode::ValidateFlow) {
+            SIM_LOG(Attach, Summary) std::cout << "Admission check: " << admitted << "/" << batch.size() << " admitted, weight "
+                      << admittedWeight << " against flow bound " << boundWeight << "\n";
+        }
+    }
+
+    // Upper bound on the slice weight a batch can admit. Exact admission is a
+    // multiple-knapsack problem, so this solves its splittable relaxation as
+    // a min-cost flow: source -> UE (its minimum acceptable bandwidth, half
+    // the request) -> shortlisted slices -> sink (each slice's free capacity),
+    // with a per-kHz cost that sums to -weight for a fully admitted UE.
+    double admissionFlowBound(const std::vector<uint32_t>& batch) const {
+        std::map<uint32_t, size_t> sliceNodes;
+        for (const auto& proposal : proposals) {
+            for (size_t c = 0; c < proposal.size(); ++c) {
+                sliceNodes.emplace(proposal[c].slice.raw(), 0);
+            }
+        }
+        const size_t source = 0, sink = 1, firstUe = 2, firstSlice = firstUe + batch.size();
+        size_t next = firstSlice;
+        for (auto& [raw, node] : sliceNodes) {
+            node = next++;
+        }
+
+        MinCostFlow flow(next);
+        for (size_t k = 0; k < batch.size(); ++k) {
+            uint32_t ueIndex = batch[k];
+            int64_t demand = NetworkSlice::toUnits(ues.getRequiredBandwidth(ueIndex) * 0.5);
+            if (demand <= 0 || proposals[k].empty()) continue;
+            flow.addEdge(source, firstUe + k, demand, 0);
+            for (size_t c = 0; c < proposals[k].size(); ++c) {
+                flow.addEdge(firstUe + k, sliceNodes.at(proposals[k][c].slice.raw()), demand,
+                             -ues.getAdmissionWeight(ueIndex) / demand);
+            }
+        }
+        for (const auto& [raw, node] : sliceNodes) {
+            const NetworkSlice* slice = nullptr;
+            for (const auto& proposal : proposals) {
+                for (size_t c = 0; c < proposal.size() && !slice; ++c) {
+                    if (proposal[c].slice.raw() == raw) slice = slices.get(proposal[c].slice);
+                }
+                if (slice) break;
+            }
+            if (!slice) continue;
+            double freeMHz = slice->getCapacity() - slice->getAllocatedBandwidth();
+            flow.addEdge(node, sink, NetworkSlice::toUnits(freeMHz), 0);
+        }
+
+        double cost = flow.solve(source, sink);
+        return cost < 0 ? -cost : 0;
+    }
+
+    static uint32_t stepAt(double time) {
+        return static_cast<uint32_t>(EventQueue::toTicks(time) / EventQueue::toTicks(STEP_DURATION));
+    }
+
+    // At most one outstanding attach per UE; attempts past the end of the run are dropped.
+    // Queues UE ueIndex for the attach batch at time; the first UE due at an
+    // instant schedules its one ConnectAttempt event.
+    void scheduleAttach(double time, int ueIndex) {
+        int64_t tick = EventQueue::toTicks(time);
+        if (attachPending[ueIndex] || tick >= EventQueue::toTicks(endTime)) return;
+        attachPending[ueIndex] = 1;
+        std::vector<uint32_t>& due = attachQueue[tick];
+        if (due.empty()) {
+            events.schedule(time, EventQueue::EventType::ConnectAttempt);
+        }
+        due.push_back(static_cast<uint32_t>(ueIndex));
+    }
+
+    // Adds the station and its own pool per slice type, sized by its band
+    // unless the site brings its own; the caller rebuilds the grid.
+    StationHandle placeStation(const Scenario::Station& site) {
+        StationHandle handle = baseStations.emplace(site.id, site.x, site.y, site.frequency, site.power, site.height);
+        BaseStation& station = *baseStations.get(handle);
+        station.setPrbCount(site.prbCount);
+        station.generateShadowingMap(rng);
+        createStationSlices(handle, site.sliceProfiles.value_or(bandProfilesFor(station)));
+        return handle;
+    }
+
+    void createStationSlices(StationHandle handle, const NetworkSlice::ProfileSet& profiles) {
+        for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+            auto sliceType = static_cast<NetworkSlice::SliceType>(type);
+            SliceHandle slice = slices.emplace(nextSliceId++, sliceType, profiles[type].priority,
+                                               profiles[type].bandwidth, handle);
+            baseStations.get(handle)->setSlice(sliceType, slice);
+        }
+    }
+
+    const NetworkSlice::ProfileSet& bandProfilesFor(const BaseStation& station) const {
+        return scenario.bandSliceProfiles[static_cast<size_t>(station.getBand())];
+    }
+
+    // A pre-drawn population (binary scenario) is used in place, its
+    // per-UE state allocated when the run starts; otherwise each UE is drawn
+    // from the seed.
+    void createUserEquipment() {
+        const Scenario::Population& population = scenario.population;
+
+        if (const auto& drawn = population.drawn) {
+            ues.addColumns(drawn->x, drawn->y, drawn->speed, drawn->slice, drawn->bandwidth,
+                           std::min(population.count, drawn->count), drawn->owner);
+        } else {
+            ues.reserve(population.count);
+            for (uint32_t i = 1; i <= population.count; ++i) {
+                Scenario::Population::Ue ue = population.draw(rng, i);
+                ues.add(ue.x, ue.y, ue.speed, ue.slice, ue.bandwidth);
+            }
+        }
+        SIM_LOG(Status, Summary) {
+            std::cout << "Created " << ues.size() << " user equipment instances (" << ues.bytesPerUe()
+                      << " bytes of state each)\n";
+        }
+    }
+
+    struct KpiCounters {
+        uint32_t attachAttempts = 0;
+        uint32_t attachFailures = 0;
+        uint32_t handovers = 0;
+        uint32_t handoverFailures = 0;
+        uint32_t radioLinkFailures = 0;
+    };
+
+    // Event counters of a cell and slice since the last KPI row; position 0
+    // stands for "no station", cell c is position c + 1
+    KpiCounters& kpiCountersFor(StationHandle station, NetworkSlice::SliceType slice) {
+        kpiCounters.resize((baseStations.size() + 1) * NetworkSlice::TYPE_COUNT);
+        size_t position = baseStations.contains(station) ? baseStations.indexOf(station) + 1 : 0;
+        return kpiCounters[position * NetworkSlice::TYPE_COUNT + static_cast<size_t>(slice)];
+    }
+
+    // One row per (cell, slice) and one per slice for attach attempts with no
+    // station. Counters cover the events since the previous report; the
+    // connection state and SINR are a snapshot at the end of the step.
+    void recordKpis(uint32_t step) {
+        constexpr size_t TYPES = NetworkSlice::TYPE_COUNT;
+        const size_t buckets = (baseStations.size() + 1) * TYPES;
+        kpiCounters.resize(buckets);
+
+        // Connected UEs' SINR by (cell, slice), one row per bucket built in parallel
+        bucketUes(buckets, kpiSinrStart, kpiUes, [this](size_t i) {
+            if (!ues.isConnected(i)) return NO_BUCKET;
+            return static_cast<uint32_t>((baseStations.indexOf(ues.getServingStation(i)) + 1) * TYPES +
+                                         static_cast<size_t>(ues.getRequiredSlice(i)));
+        });
+        kpiSinr.resize(kpiUes.size());
+        kpiRows.resize(buckets);
+        pool.parallelFor(kpiUes.size(), PARALLEL_THRESHOLD, [this](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; ++k) {
+                kpiSinr[k] = ues.getCurrentSignal(kpiUes[k]);
+            }
+        });
+
+        pool.parallelFor(buckets, 2, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end; ++b) {
+                kpiRows[b] = kpiRow(step, b);
+            }
+        });
+        for (size_t b = 0; b < buckets; ++b) {
+            kpiFile.append(kpiRows[b]);
+        }
+        std::fill(kpiCounters.begin(), kpiCounters.end(), KpiCounters{});
+    }
+
+    // KPI row of bucket b = (cell position + 1) * TYPE_COUNT + slice, from
+    // the counters and the bucket's SINR range laid out by recordKpis.
+    // Sorts only that range, so different buckets may be built concurrently.
+    KpiFile::Row kpiRow(uint32_t step, size_t b) {
+        constexpr size_t TYPES = NetworkSlice::TYPE_COUNT;
+        size_t position = b / TYPES;
+        auto sliceType = static_cast<NetworkSlice::SliceType>(b % TYPES);
+        KpiFile::Row row;
+        row.step = step;
+        row.slice = sliceType;
+        row.attachAttempts = kpiCounters[b].attachAttempts;
+        row.attachFailures = kpiCounters[b].attachFailures;
+        row.handovers = kpiCounters[b].handovers;
+        row.handoverFailures = kpiCounters[b].handoverFailures;
+        row.radioLinkFailures = kpiCounters[b].radioLinkFailures;
+        if (position > 0) {
+            const BaseStation& station = baseStations[position - 1];
+            row.gnb = station.getId();
+            if (const NetworkSlice* slice = slices.get(station.getSlice(sliceType))) {
+                row.allocatedMhz = static_cast<float>(slice->getAllocatedBandwidth());
+                row.capacityMhz = static_cast<float>(slice->getCapacity());
+            }
+        }
+
+        float* first = kpiSinr.data() + kpiSinrStart[b];
+        size_t count = kpiSinrStart[b + 1] - kpiSinrStart[b];
+        row.connected = static_cast<uint32_t>(count);
+        if (count == 0) {
+            row.sinrMean = row.sinrP5 = row.sinrP50 = row.sinrP95 = std::numeric_limits<float>::quiet_NaN();
+        } else {
+            double sum = 0;
+            for (size_t u = 0; u < count; ++u) sum += first[u];
+            row.sinrMean = static_cast<float>(sum / count);
+            // Nearest-rank percentiles, rank ceil(p n). The median is
+            // selected first; it partitions the range, so p5 only
+            // searches below it and p95 only above it.
+            auto rank = [&](size_t percent) { return std::max<size_t>((percent * count + 99) / 100, 1) - 1; };
+            auto select = [&](size_t nth, size_t begin, size_t end) {
+                std::nth_element(first + begin, first + nth, first + end);
+                return first[nth];
+            };
+            const size_t median = rank(50);
+            row.sinrP50 = select(median, 0, count);
+            row.sinrP5 = rank(5) < median ? select(rank(5), 0, median) : row.sinrP50;
+            row.sinrP95 = rank(95) > median ? select(rank(95), median + 1, count) : row.sinrP50;
+        }
+        return row;
+    }
+
+    // Live station with the given id, or an invalid handle
+    StationHandle findStation(int id) const {
+        for (size_t s = 0; s < baseStations.size(); ++s) {
+            if (baseStations[s].getId() == id) return baseStations.handleAt(s);
+        }
+        return StationHandle{};
+    }
+
+    // Median RSRP under which a station serves no slice even on a favourable
+    // shadowing draw; sets the coverage radii the station grid is built from.
+    double coverageThreshold() const {
+        double floor = std::numeric_limits<double>::infinity();
+        for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+            floor = std::min(floor, ues.getSliceRequirements(static_cast<NetworkSlice::SliceType>(type)).minRsrp);
+        }
+        return floor - COVERAGE_MARGIN;
+    }
+
+    // Each block is reported by its own subsystem; counters reset regardless
+    void displayStatus() {
+        SIM_LOG(Status, Summary) displayNetworkStatus();
+        SIM_LOG(Scheduler, Summary) displayCellThroughput();
+
+        SIM_LOG(Handover, Summary) {
+            std::cout << "Mobility: " << handovers << " handovers, " << failedHandovers << " failed, "
+                      << radioLinkFailures << " radio link failures\n";
+        }
+        handovers = failedHandovers = radioLinkFailures = 0;
+
+        SIM_LOG(Status, Summary) {
+            std::cout << "Measurements: " << measurementsRefreshed << " refreshed, "
+                      << measurementsReused << " reused from cache\n";
+        }
+        measurementsRefreshed = measurementsReused = 0;
+    }
+
+    void displayNetworkStatus() {
+        std::array<std::atomic<size_t>, NetworkSlice::TYPE_COUNT> sliceCounts{};
+        pool.parallelFor(ues.size(), PARALLEL_THRESHOLD, [&](size_t begin, size_t end) {
+            std::array<size_t, NetworkSlice::TYPE_COUNT> counts{};
+            for (size_t i = begin; i < end; ++i) {
+                if (ues.isConnected(i)) counts[static_cast<size_t>(ues.getRequiredSlice(i))]++;
+            }
+            for (size_t type = 0; type < NetworkSlice::TYPE_COUNT; ++type) {
+                sliceCounts[type] += counts[type];
+            }
+        });
+        size_t connected = 0;
+        for (const auto& count : sliceCounts) {
+            connected += count;
+        }
+
+        std::cout << "Network Status: " << connected << "/" << ues.size()
+                  << " UEs connected (" << (100.0 * connected / ues.size()) << "%)\n";
+
+        std::cout << "Slice Distribution:\n";
+        for (size_t slot = 0; slot < NetworkSlice::TYPE_COUNT; ++slot) {
+            const size_t count = sliceCounts[slot];
+            if (count == 0) continue;
+            auto type = static_cast<NetworkSlice::SliceType>(slot);
+            std::string name;
+            switch (type) {
+                case NetworkSlice::SliceType::eMBB: name = "eMBB"; break;
+                case NetworkSlice::SliceType::URLLC: name = "URLLC"; break;
+                case NetworkSlice::SliceType::mMTC: name = "mMTC"; break;
+            }
+            std::cout << "  " << name << ": " << count << " UEs\n";
+        }
+
+        // The pools sit contiguously in the slot map, so per-cell load is one
+        // scan into arrays indexed like the stations
+        cellAllocated.assign(baseStations.size(), 0.0);
+        cellCapacity.assign(baseStations.size(), 0.0);
+        for (const auto& slice : slices) {
+            size_t cell = baseStations.indexOf(slice.getStation());
+            cellAllocated[cell] += slice.getAllocatedBandwidth();
+            cellCapacity[cell] += slice.getCapacity();
+        }
+
+        std::cout << "Cell Load:\n";
+        for (size_t cell : cellsById()) {
+            std::cout << "  gNB " << baseStations[cell].getId() << ": " << cellAllocated[cell] << "/"
+                      << cellCapacity[cell] << " MHz\n";
+        }
+    }
+
+    void displayCellThroughput() const {
+        std::cout << "Cell Throughput (" << scheduler.getPolicyName() << "):\n";
+        for (size_t cell : cellsById()) {
+            if (cell >= cellBits.size()) continue;
+            std::cout << "  gNB " << baseStations[cell].getId() << ": "
+                      << cellBits[cell] / STEP_DURATION / 1e6 << " Mbps\n";
+        }
+    }
+
+    // Dense station indices in gNB id order, the order status lines are
+    // printed in whatever swap-removes did to the slot map
+    std::vector<size_t> cellsById() const {
+        std::vector<size_t> order(baseStations.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return baseStations[a].getId() < baseStations[b].getId();
+        });
+        return order;
+    }
+
+    SlotMap<BaseStation> baseStations;
+    StationGrid stationGrid;
+    SlotMap<NetworkSlice> slices;
+    int nextSliceId = 1;
+    UserEquipmentStore ues;
+    CounterRng rng;
+
+    Scenario scenario;
+
+    // Below this many items a batch is not worth handing to the pool
+    static constexpr size_t PARALLEL_THRESHOLD = 256;
+    // UEs per SignalKernel call during attach evaluation
+    static constexpr size_t MEASUREMENT_BLOCK = 64;
+    static constexpr uint32_t SLOTS_PER_STEP =
+            static_cast<uint32_t>(STEP_DURATION / MacScheduler::SLOT_DURATION + 0.5);
+
+    MacScheduler scheduler;
+
+    ThreadPool pool;
+    EventQueue events;
+    std::vector<uint8_t> attachPending;  // queued in attachQueue
+    std::map<int64_t, std::vector<uint32_t>> attachQueue;  // UEs due to attempt an attach, by tick
+    std::vector<UserEquipmentStore::CandidateShortlist> proposals;
+    std::vector<uint32_t> attachCells;
+    std::vector<uint32_t> attachOrder;
+    std::vector<uint32_t> admissionOrder;
+    std::vector<uint32_t> cellUeStart;  // connected UEs of cell c: cellUes[cellUeStart[c], cellUeStart[c + 1])
+    std::vector<uint32_t> cellUes;
+    std::vector<uint32_t> ueBucket;     // bucketUes scratch: each UE's bucket
+    std::vector<uint32_t> partOffsets;  // bucketUes scratch: counts, then cursors, per (range, bucket)
+    std::vector<float> cellSinr;
+    std::vector<double> cellBits;       // delivered in the last scheduled step, per cell
+    double endTime = 0;
+    bool realTimePacing = false;
+    AdmissionMode admissionMode = AdmissionMode::Greedy;
+    UserEquipmentStore::HandoverParameters handoverParameters;
+    std::vector<uint32_t> reportingUes;  // listed by move(), in UE order
+    std::vector<UserEquipmentStore::MeasurementReport> reports;  // one per reporting UE
+    std::vector<uint8_t> reportActions;   // updateLinkState flags, one per reporting UE
+    std::vector<uint32_t> pendingReports;  // reports with flags set, in UE order
+    std::vector<uint32_t> sessionChanges;  // idle UEs and sessions drawn for release
+    std::vector<uint32_t> releasingUes;
+    int handovers = 0, failedHandovers = 0, radioLinkFailures = 0;  // since the last status report
+    EventLog eventLog;
+
+    KpiFile kpiFile;
+    std::vector<KpiCounters> kpiCounters;  // by (cell position, slice), see kpiCountersFor
+    std::vector<uint32_t> kpiSinrStart;
+    std::vector<uint32_t> kpiUes;
+    std::vector<float> kpiSinr;
+    std::vector<KpiFile::Row> kpiRows;
+    std::vector<double> cellAllocated, cellCapacity;  // MHz by dense station index, for the status report
+    std::atomic<size_t> measurementsRefreshed = 0, measurementsReused = 0;
+};
+
+static void printUsage(std::ostream& out, const char* program) {
+    out << "Usage: " << program << " [options]\n"
+        << "  --scenario PATH            JSON or binary scenario to run\n"
+        << "  --ues N                    override the scenario's UE count\n"
+        << "  --steps N                  override the scenario's number of steps\n"
+        << "  --seed N                   seed for every random draw\n"
+        << "  --convert-scenario PATH    write the scenario as a binary image and exit\n"
+        << "  --threads N                worker pool size (default: all cores)\n"
+        << "  --realtime                 pace events against the wall clock\n"
+        << "  --simd scalar|avx2|avx512  widest instruction set for the kernels\n"
+        << "  --scheduler rr|pf|maxci    MAC scheduling policy (default: pf)\n"
+        << "  --admission greedy|validate  also print a flow bound per attach batch\n"
+        << "  --refresh-distance M       meters moved before a UE re-measures (0-"
+        << SHADOWING_DECORRELATION_DISTANCE << ")\n"
+        << "  --log SPEC                 off|summary|event, or subsystem=level,...\n"
+        << "  --event-log PATH           write per-UE events to a binary log\n"
+        << "  --decode-log PATH          print a binary event log and exit\n"
+        << "  --kpi-file PATH            write per-step KPIs to a columnar file\n"
+        << "  --kpi-compress             delta/varint compress the KPI integer columns\n"
+        << "  --kpi-dump PATH            print a KPI file as CSV and exit\n"
+        << "  --help                     show this message\n";
+}
+
+// A whole command-line value as a number within [min, max], or nothing
+template <typename Number>
+static std::optional<Number> parseNumber(std::string_view text, Number min, Number max) {
+    Number value{};
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size() || !(value >= min && value <= max)) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+int main(int argc, char* argv[]) {
+    bool realTime = false;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::optional<uint64_t> seed;
+    std::string scenarioPath;
+    std::optional<size_t> ueCount;
+    std::optional<int> steps;
+    std::string convertPath;
+    MacScheduler::Policy scheduler = MacScheduler::Policy::ProportionalFair;
+    auto admission = FiveGNetwork::AdmissionMode::Greedy;
+    double refreshDistance = MEASUREMENT_REFRESH_DISTANCE;
+    std::string eventLogPath;
+    std::string kpiPath;
+    bool kpiCompress = false;
+
+    // Malformed command lines are rejected as strictly as scenario files are
+    auto usageError = [&](const std::string& message) {
+        std::cerr << argv[0] << ": " << message << "\n";
+        printUsage(std::cerr, argv[0]);
+        return 1;
+    };
+    static constexpr std::array<std::string_view, 15> VALUE_OPTIONS = {
+            "--threads", "--seed", "--scenario", "--ues", "--steps", "--convert-scenario", "--simd", "--scheduler",
+            "--log", "--kpi-file", "--kpi-dump", "--event-log", "--decode-log", "--refresh-distance", "--admission"
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value;
+        if (std::find(VALUE_OPTIONS.begin(), VALUE_OPTIONS.end(), arg) != VALUE_OPTIONS.end()) {
+            if (i + 1 == argc) return usageError("missing value for " + arg);
+            value = argv[++i];
+        }
+        auto invalid = [&] { return usageError("invalid value for " + arg + ": " + value); };
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage(std::cout, argv[0]);
+            return 0;
+        } else if (arg == "--realtime") {
+            realTime = true;
+        } else if (arg == "--threads") {
+            auto count = parseNumber<size_t>(value, 1, 4096);
+            if (!count) return invalid();
+            threads = *count;
+        } else if (arg == "--seed") {
+            seed = parseNumber<uint64_t>(value, 0, std::numeric_limits<uint64_t>::max());
+            if (!seed) return invalid();
+        } else if (arg == "--scenario") {
+            scenarioPath = value;
+        } else if (arg == "--ues") {
+            // The same bound as a scenario's population.count
+            ueCount = parseNumber<size_t>(value, 0, std::numeric_limits<uint32_t>::max() - 1);
+            if (!ueCount) return invalid();
+        } else if (arg == "--steps") {
+            steps = parseNumber<int>(value, 0, std::numeric_limits<int32_t>::max());
+            if (!steps) return invalid();
+        } else if (arg == "--convert-scenario") {
+            convertPath = value;
+        } else if (arg == "--simd") {
+            if (value == "scalar") SignalKernel::setIsa(SignalKernel::Isa::Scalar);
+            else if (value == "avx2") SignalKernel::setIsa(SignalKernel::Isa::Avx2);
+            else if (value == "avx512") SignalKernel::setIsa(SignalKernel::Isa::Avx512);
+            else return invalid();
+        } else if (arg == "--scheduler") {
+            if (value == "rr") scheduler = MacScheduler::Policy::RoundRobin;
+            else if (value == "pf") scheduler = MacScheduler::Policy::ProportionalFair;
+            else if (value == "maxci") scheduler = MacScheduler::Policy::MaxCI;
+            else return invalid();
+        } else if (arg == "--log") {
+            if (!Log::configure(value)) return invalid();
+        } else if (arg == "--kpi-file") {
+            kpiPath = value;
+        } else if (arg == "--kpi-compress") {
+            kpiCompress = true;
+        } else if (arg == "--kpi-dump") {
+            if (!KpiFile::dump(value, std::cout)) {
+                std::cerr << "Cannot read KPI file " << value << "\n";
+                return 1;
+            }
+            return 0;
+        } else if (arg == "--event-log") {
+            eventLogPath = value;
+        } else if (arg == "--decode-log") {
+            if (!EventLog::decode(value, std::cout)) {
+                std::cerr << "Cannot decode event log " << value << "\n";
+                return 1;
+            }
+            return 0;
+        } else if (arg == "--refresh-distance") {
+            auto meters = parseNumber<double>(value, 0.0, SHADOWING_DECORRELATION_DISTANCE);
+            if (!meters) return invalid();
+            refreshDistance = *meters;
+        } else if (arg == "--admission") {
+            if (value == "greedy") admission = FiveGNetwork::AdmissionMode::Greedy;
+            else if (value == "validate") admission = FiveGNetwork::AdmissionMode::ValidateFlow;
+            else return invalid();
+        } else {
+            return usageError("unknown option " + arg);
+        }
+    }
+
+    // Command-line values win over the scenario file, whatever the argument order
+    Scenario scenario;
+    std::string scenarioError;
+    if (!scenarioPath.empty() && !(ScenarioImage::isImage(scenarioPath)
+                                   ? ScenarioImage::load(scenarioPath, scenario, scenarioError)
+                                   : scenario.load(scenarioPath, scenarioError))) {
+        std::cerr << "Invalid scenario " << scenarioPath << ": " << scenarioError << "\n";
+        return 1;
+    }
+    if (ueCount) {
+        // A pre-drawn population can be cut short, but not extended
+        if (scenario.population.drawn && *ueCount > scenario.population.drawn->count) {
+            std::cerr << "Scenario " << scenarioPath << " holds only " << scenario.population.drawn->count
+                      << " UEs\n";
+            return 1;
+        }
+        scenario.population.count = *ueCount;
+    }
+    if (steps) scenario.steps = *steps;
+    uint64_t runSeed = seed.value_or(scenario.seed.value_or(DEFAULT_SEED));
+
+    if (!convertPath.empty()) {
+        if (!ScenarioImage::write(convertPath, scenario, CounterRng(runSeed), runSeed, scenarioError)) {
+            std::cerr << "Cannot convert scenario: " << scenarioError << "\n";
+            return 1;
+        }
+        std::cout << "Wrote " << scenario.stations.size() << " stations and " << scenario.population.count
+                  << " UEs to " << convertPath << "\n";
+        return 0;
+    }
+
+    FiveGNetwork network(threads, runSeed);
+    network.setScenario(scenario);
+    network.setRealTimePacing(realTime);
+    network.setSchedulerPolicy(scheduler);
+    network.setAdmissionMode(admission);
+    network.setMeasurementRefreshDistance(refreshDistance);
+    if (!eventLogPath.empty() && !network.setEventLogFile(eventLogPath)) {
+        std::cerr << "Cannot create event log " << eventLogPath << ", logging to stdout\n";
+    }
+    if (!kpiPath.empty() && !network.setKpiFile(kpiPath, kpiCompress)) {
+        std::cerr << "Cannot create KPI file " << kpiPath << "\n";
+    }
     network.initialize();
-    network.runSimulation(10);
+    network.runSimulation(scenario.steps);
     return 0;
 }
\ No newline at end of file